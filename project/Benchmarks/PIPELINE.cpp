@@ -0,0 +1,439 @@
+/* Pipeline Benchmark
+
+	Measures every stage a sample goes through, on two sources that
+	need no sensor:
+
+		simulated	a SimulatedLSM303 with a manual clock, rotating
+					at 0.5 Hz, read with no bus latency
+		replay		a PrettyData capture played through a
+					CaptureReplay as fast as possible; without a
+					capture argument the simulated samples are
+					written out with PDUMP's layout and replayed
+
+	Stages, each run on the samples of each source:
+
+		acquire			simulated: ADA10DOFAccelerometer::readSample()
+						replay: CaptureReplay into an AcquisitionSession
+		coalesce		simulated only: STATUS_REG_A, the six data
+						bytes, FIFO_SRC_REG_A and the magnetometer
+						temperature queued per sample on a
+						CoalescingQueue.h and flushed
+		convert			CONVERT.c's CONVERT() on the six bytes
+		decode			convertAcceleration() and orientation through
+						ADA10DOFAccelerometer::decodeSample()
+		orientation		pitchAndRoll() alone
+		lsave			CONVERT.c's LSAVE(), from a RAWData.txt per sample
+		pdump			CONVERT.c's PDUMP() of what LSAVE stored
+		session			AcquisitionSession push and pop, including
+						its store and process latency records
+		latency			one LatencyHistogram mark, the cost each
+						instrumented stage adds per sample
+		trace-off		one TRACE_SCOPE with the recorder disabled
+		trace-on		the same with it recording
+		resample-linear	Resampler onto a BENCH_RESAMPLE_RATE grid, per
+		resample-sinc	input sample
+		codec-encode	CaptureCodec.h blocks from the raw bytes and
+						sample times
+		codec-decode	the same blocks back to codec_samples
+		writer			the same blocks handed to a CaptureWriter.h,
+						the cost to the draining thread; the file is
+						closed after the stage
+		store-append	the same samples into a SampleStore.h store
+		store-scan		a full time range scan of it
+
+	One JSON object per line and stage, so runs can be diffed or
+	collected by a script:
+
+		{"bench":"decode","source":"replay","samples":100000,"seconds":...,
+		 "samples_per_sec":...,"ns_per_sample":...,"allocations":...,
+		 "allocations_per_sample":...,"cpu_seconds":...}
+
+	The codec, writer and store stages add "bytes_per_sample", the encoded
+	size or the store's memory. coalesce adds the queue's counters,
+	"requested", "issued", "merged" and "extra_bytes".
+
+	allocations counts malloc and operator new calls made during
+	the stage. LSAVE leaks a FILE per call, so that stage is capped
+	below the descriptor limit. The files are written in a fresh
+	directory under /tmp.
+
+	Build:	gcc -O2 -c -Dmain=CONVERT_main ../CONVERT.c -o CONVERT.o
+			g++ -std=c++11 -O2 -pthread -I../Includes PIPELINE.cpp CONVERT.o -lm -o PIPELINE
+	Usage:	./PIPELINE [samples] [capture rate]
+*/
+
+#include "10DOFDrive.h"
+#include "CaptureCodec.h"
+#include "CaptureReplay.h"
+#include "CaptureWriter.h"
+#include "CoalescingQueue.h"
+#include "Resampler.h"
+#include "SampleStore.h"
+#include "SimulatedLSM303.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#define BENCH_RATE		400		// Capture rate assumed for the replay timeline
+#define BENCH_LSAVE_MAX	400		// LSAVE leaks one FILE per call, both sources must stay under 1024
+#define BENCH_RESAMPLE_RATE	1000	// Output grid of the resample stages, Hz
+
+extern "C" {
+	extern int read_count;				// CONVERT.c globals and functions
+	void LSAVE(void);
+	void PDUMP(void);
+	int  CONVERT(int hex);
+
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t count, size_t size);
+	void *__libc_realloc(void *pointer, size_t size);
+	void  __libc_free(void *pointer);
+}
+
+static std::atomic<unsigned long> allocations(0);	// Every malloc in the process, C and C++
+
+extern "C" void *malloc(size_t size) { allocations++; return __libc_malloc(size); }
+extern "C" void *calloc(size_t count, size_t size) { allocations++; return __libc_calloc(count, size); }
+extern "C" void *realloc(void *pointer, size_t size) { allocations++; return __libc_realloc(pointer, size); }
+extern "C" void  free(void *pointer) { __libc_free(pointer); }
+
+/* Measure structure
+	Wall time, CPU time and allocations around one stage.
+*/
+struct Measure {
+	const char *bench, *source;
+	long long wall;
+	double cpu;
+	unsigned long allocated;
+};
+
+static long long monotonicNanoseconds(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static double cpuSeconds(){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static Measure begin(const char *bench, const char *source){
+	Measure m = { bench, source, monotonicNanoseconds(), cpuSeconds(), allocations };
+	return m;
+}
+
+static void finish(const Measure &m, size_t samples, size_t bytes = 0, const char *extra = NULL){
+	long long wall = monotonicNanoseconds() - m.wall;
+	double cpu = cpuSeconds() - m.cpu;
+	unsigned long allocated = allocations - m.allocated;
+	printf("{\"bench\":\"%s\",\"source\":\"%s\",\"samples\":%zu,\"seconds\":%.6f,"
+		"\"samples_per_sec\":%.1f,\"ns_per_sample\":%.2f,\"allocations\":%lu,"
+		"\"allocations_per_sample\":%.3f,\"cpu_seconds\":%.6f",
+		m.bench, m.source, samples, wall / 1e9,
+		wall > 0 ? samples * 1e9 / wall : 0.0, samples ? (double)wall / samples : 0.0,
+		allocated, samples ? (double)allocated / samples : 0.0, cpu);
+	if (bytes > 0){printf(",\"bytes_per_sample\":%.2f", samples ? (double)bytes / samples : 0.0);}
+	if (extra != NULL){printf(",%s", extra);}
+	printf("}\n");
+	fflush(stdout);
+}
+
+/* simulatedSource function
+	Times the driver's acquisition loop on the simulator and keeps
+	the raw bytes of every sample for the later stages.
+*/
+static std::vector<RawSample> simulatedSource(size_t count){
+	SimulatedLSM303 *device = new SimulatedLSM303();
+	device->useManualClock(true);
+	device->setMotion(SIM_ROTATION, 0, 0.5);
+	device->writeRegister(CTRL_REG1_A, 0x97);				// 1344 Hz, all axes
+
+	std::streambuf *console = cout.rdbuf(NULL);				// The constructor's register dump is noise here
+	ADA10DOFAccelerometer driver(device);
+	cout.rdbuf(console);
+
+	long long period = 1000000000LL / 1344;
+	Measure m = begin("acquire", "simulated");
+	for (size_t i = 0; i < count; i++){
+		device->advanceClock(period);
+		driver.readSample();
+	}
+	finish(m, count);
+
+	std::vector<RawSample> samples(count);					// Same motion again, raw this time
+	SimulatedLSM303 raw;
+	raw.useManualClock(true);
+	raw.setMotion(SIM_ROTATION, 0, 0.5);
+	raw.writeRegister(CTRL_REG1_A, 0x97);
+	for (size_t i = 0; i < count; i++){
+		raw.advanceClock(period);
+		raw.readRegistersAt(0x19, 0x28 | 0x80, (char *)samples[i].data, SESSION_SAMPLE_BYTES);
+		samples[i].sequence = i + 1;
+		samples[i].timestamp = i * period;
+		samples[i].sampleTime = i * period;
+	}
+	return samples;
+}
+
+/* coalesceStage function
+	Times the reads a sample needs when each consumer queues its
+	own, and shows how many transfers merging saved.
+*/
+static void coalesceStage(size_t count){
+	SimulatedLSM303 device;
+	device.useManualClock(true);
+	device.writeRegister(CTRL_REG1_A, 0x97);
+	CoalescingQueue queue(device);
+	queue.setAutoIncrement(0x1E, 0);													// The magnetometer increments without 0x80
+	unsigned char status = 0, fifo = 0, temperature[2];
+	unsigned char data[SESSION_SAMPLE_BYTES];
+	long long period = 1000000000LL / 1344;
+
+	Measure m = begin("coalesce", "simulated");
+	for (size_t i = 0; i < count; i++){
+		device.advanceClock(period);
+		queue.read(0x19, 0x27, 1, [&](int, const char *d, int){ status = d[0]; });				// STATUS_REG_A
+		queue.read(0x19, 0x28, SESSION_SAMPLE_BYTES, [&](int, const char *d, int n){ memcpy(data, d, n); });
+		queue.read(0x19, 0x2F, 1, [&](int, const char *d, int){ fifo = d[0]; });				// FIFO_SRC_REG_A
+		queue.read(0x1E, 0x31, 2, [&](int, const char *d, int){ memcpy(temperature, d, 2); });	// TEMP_OUT_H_M
+		queue.flush();
+	}
+	char counters[160];
+	snprintf(counters, sizeof(counters), "\"requested\":%lu,\"issued\":%lu,\"merged\":%lu,\"extra_bytes\":%lu",
+		queue.getRequested(), queue.getIssued(), queue.getMerged(), queue.getExtraBytes());
+	finish(m, count, 0, counters);
+	volatile long sink = status + fifo + data[5] + temperature[0];	// Keeps results alive
+	(void)sink;
+}
+
+/* replaySource function
+	Times a capture replayed as fast as possible into a session,
+	drained by this thread as a consumer would.
+*/
+static std::vector<RawSample> replaySource(const char *capture, double rate){
+	CaptureReplay replay(rate, REPLAY_UNPACED);
+	if (replay.load(capture) <= 0){return std::vector<RawSample>();}
+
+	std::vector<RawSample> samples(replay.getLoaded());
+	AcquisitionSession session(-1, 0x19, rate);
+	size_t got = 0;
+	Measure m = begin("acquire", "replay");
+	replay.start(&session);
+	while (got < samples.size()){
+		size_t n = session.pop(&samples[got], samples.size() - got);
+		if (n == 0){sched_yield();}
+		got += n;
+	}
+	replay.wait();
+	finish(m, got);
+	return samples;
+}
+
+static void writeCapture(const char *filename, const std::vector<RawSample> &samples){
+	FILE *fpOUT = fopen(filename, "w");
+	for (size_t i = 0; i < samples.size(); i++){
+		const unsigned char *d = samples[i].data;
+		fprintf(fpOUT, "%u\t0x%x 0x%x 0x%x 0x%x 0x%x 0x%x\n", samples[i].sequence, d[0], d[1], d[2], d[3], d[4], d[5]);
+	}
+	fclose(fpOUT);
+}
+
+/* stages function
+	Runs every processing stage on the samples of one source.
+*/
+static void stages(const char *source, const std::vector<RawSample> &samples){
+	size_t count = samples.size();
+	volatile long sink = 0;									// Keeps results alive
+
+	// CONVERT prints every bit pattern, which belongs to the stage
+	fflush(stdout);
+	int console = dup(STDOUT_FILENO);
+	if (freopen("/dev/null", "w", stdout) == NULL){return;}
+	Measure m = begin("convert", source);
+	for (size_t i = 0; i < count; i++){
+		for (int b = 0; b < SESSION_SAMPLE_BYTES; b++){sink += CONVERT(samples[i].data[b]);}
+	}
+	fflush(stdout);
+	dup2(console, STDOUT_FILENO);
+	close(console);
+	clearerr(stdout);
+	finish(m, count);
+
+	std::streambuf *log = cout.rdbuf(NULL);
+	ADA10DOFAccelerometer driver(new SimulatedLSM303());	// Only its decoder is used
+	cout.rdbuf(log);
+	m = begin("decode", source);
+	for (size_t i = 0; i < count; i++){
+		driver.decodeSample(samples[i].data);
+		sink += driver.getAccelerationZ();
+	}
+	finish(m, count);
+
+	m = begin("orientation", source);
+	for (size_t i = 0; i < count; i++){
+		const unsigned char *d = samples[i].data;
+		double pitch, roll;
+		pitchAndRoll((short)(d[1] << 8 | d[0]) >> 2, (short)(d[3] << 8 | d[2]) >> 2, (short)(d[5] << 8 | d[4]) >> 2,
+			&pitch, &roll);
+		sink += (long)pitch;
+	}
+	finish(m, count);
+
+	size_t saved = count < BENCH_LSAVE_MAX ? count : BENCH_LSAVE_MAX;
+	read_count = 0;
+	m = begin("lsave", source);
+	for (size_t i = 0; i < saved; i++){
+		FILE *raw = fopen("RAWData.txt", "w");				// What BUS_READ leaves behind
+		for (int b = 0; b < SESSION_SAMPLE_BYTES; b++){fprintf(raw, "%#x\n", samples[i].data[b]);}
+		fclose(raw);
+		read_count++;
+		LSAVE();
+	}
+	finish(m, saved);
+
+	m = begin("pdump", source);
+	PDUMP();
+	finish(m, saved);
+
+	AcquisitionSession session(-1, 0x19, BENCH_RATE, 1024);
+	RawSample out[64];
+	m = begin("session", source);
+	for (size_t i = 0; i < count; i += 64){
+		size_t n = count - i < 64 ? count - i : 64;
+		for (size_t j = 0; j < n; j++){session.push((const char *)samples[i + j].data, samples[i + j].timestamp);}
+		sink += session.pop(out, 64);
+	}
+	finish(m, count);
+
+	long long released = monotonicNanoseconds();
+	m = begin("latency", source);
+	for (size_t i = 0; i < count; i++){pipelineLatency().mark(LATENCY_DECODE, released);}
+	finish(m, count);
+
+	m = begin("trace-off", source);
+	for (size_t i = 0; i < count; i++){
+		TRACE_SCOPE("bench");
+		sink += i;
+	}
+	finish(m, count);
+
+	traceRecorder().setEnabled(true);
+	m = begin("trace-on", source);
+	for (size_t i = 0; i < count; i++){
+		TRACE_SCOPE("bench");
+		sink += i;
+	}
+	finish(m, count);
+	traceRecorder().setEnabled(false);
+
+	ResampledSample grid[256];
+	for (int method = RESAMPLE_LINEAR; method <= RESAMPLE_SINC; method++){
+		Resampler resampler(BENCH_RESAMPLE_RATE, (RESAMPLE_METHOD)method);
+		m = begin(method == RESAMPLE_LINEAR ? "resample-linear" : "resample-sinc", source);
+		for (size_t i = 0; i < count; i += 64){
+			size_t n = count - i < 64 ? count - i : 64;
+			for (size_t j = 0; j < n; j++){
+				const unsigned char *d = samples[i + j].data;
+				resampler.push(samples[i + j].timestamp,
+					(short)(d[1] << 8 | d[0]) >> 2, (short)(d[3] << 8 | d[2]) >> 2, (short)(d[5] << 8 | d[4]) >> 2);
+			}
+			size_t got;
+			while ((got = resampler.pull(grid, 256)) > 0){sink += (long)grid[got - 1].z;}
+		}
+		finish(m, count);
+	}
+
+	std::vector<codec_sample> input(count), decoded(count + CODEC_BLOCK);
+	for (size_t i = 0; i < count; i++){
+		const unsigned char *d = samples[i].data;
+		input[i].time = samples[i].sampleTime;
+		input[i].sequence = samples[i].sequence;
+		for (int a = 0; a < 3; a++){input[i].axis[a] = (int16_t)(d[2 * a] | d[2 * a + 1] << 8);}
+	}
+	std::vector<unsigned char> encoded((count / CODEC_BLOCK + 1) * CODEC_MAX_BLOCK);
+	size_t bytes = 0;
+	m = begin("codec-encode", source);
+	for (size_t i = 0; i < count; i += CODEC_BLOCK){
+		int n = count - i < CODEC_BLOCK ? count - i : CODEC_BLOCK;
+		bytes += CODEC_ENCODE(&input[i], n, &encoded[bytes]);
+	}
+	finish(m, count, bytes);
+
+	size_t got = 0;
+	m = begin("codec-decode", source);
+	for (size_t at = 0; at < bytes; ){
+		int n = CODEC_DECODE(&encoded[at], bytes - at, &decoded[got]);
+		if (n < 0){break;}
+		codec_header header;
+		memcpy(&header, &encoded[at], CODEC_HEADER);
+		at += CODEC_HEADER + header.bytes;
+		got += n;
+	}
+	finish(m, got, bytes);
+	if (got != count || memcmp(&decoded[count - 1].axis, &input[count - 1].axis, sizeof(input[0].axis)) != 0){
+		fprintf(stderr, "Error: codec round trip lost samples.\n");
+	}
+
+	CaptureWriter writer;
+	if (writer.open("Capture.lsm") == 0){
+		m = begin("writer", source);
+		for (size_t at = 0; at < bytes; ){
+			codec_header header;
+			memcpy(&header, &encoded[at], CODEC_HEADER);
+			writer.write(&encoded[at], CODEC_HEADER + header.bytes);
+			at += CODEC_HEADER + header.bytes;
+		}
+		finish(m, count, bytes);
+		if (writer.close() != 0 || writer.getBytes() != bytes){fprintf(stderr, "Error: writer lost bytes.\n");}
+	}
+
+	sample_store store;
+	STORE_INIT(&store, 0);
+	m = begin("store-append", source);
+	for (size_t i = 0; i < count; i++){STORE_APPEND(&store, &input[i]);}
+	finish(m, count, STORE_BYTES(&store));
+
+	m = begin("store-scan", source);
+	got = STORE_SCAN(&store, INT64_MIN, INT64_MAX, &decoded[0], decoded.size());
+	finish(m, got, STORE_BYTES(&store));
+	if (got != count || memcmp(&decoded[count - 1].axis, &input[count - 1].axis, sizeof(input[0].axis)) != 0){
+		fprintf(stderr, "Error: store scan lost samples.\n");
+	}
+	STORE_FREE(&store);
+}
+
+int main(int argc, char *argv[]){
+	size_t count = (argc > 1) ? atol(argv[1]) : 100000;
+	const char *capture = (argc > 2) ? argv[2] : NULL;
+	double rate = (argc > 3) ? atof(argv[3]) : BENCH_RATE;
+
+	char capturePath[PATH_MAX] = "";
+	if (capture != NULL && realpath(capture, capturePath) == NULL){
+		fprintf(stderr, "Error: %s not found.\n", capture);
+		exit(1);
+	}
+	char directory[] = "/tmp/pipelineXXXXXX";				// LSAVE and PDUMP use fixed names
+	if (mkdtemp(directory) == NULL || chdir(directory) != 0){
+		fprintf(stderr, "Error: no scratch directory.\n");
+		exit(1);
+	}
+
+	std::vector<RawSample> simulated = simulatedSource(count);
+	coalesceStage(count);
+	stages("simulated", simulated);
+
+	if (capture == NULL){
+		writeCapture("Capture.txt", simulated);
+		snprintf(capturePath, sizeof(capturePath), "%s/Capture.txt", directory);
+	}
+	std::vector<RawSample> replayed = replaySource(capturePath, rate);
+	if (replayed.empty()){
+		fprintf(stderr, "Error: no samples in %s.\n", capturePath);
+		exit(1);
+	}
+	stages("replay", replayed);
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+/* Scheduler Benchmark
+
+	Measures the cost of a task switch in the AcquisitionScheduler.
+
+		yield		N tasks take turns with co_await yield(), the
+					pure coroutine switch with no syscall involved
+		tick		N tasks on a 1 ms Ticker for one second, going
+					through the timerfd and epoll_wait; reports the
+					mean and worst wake-up lateness and missed ticks
+
+	No sensor needed, none of the tasks touch the bus.
+
+	Build:	g++ -std=c++20 -O2 -pthread -I../Includes SCHEDULER.cpp -o SCHEDULER
+	Usage:	./SCHEDULER [tasks] [switches]
+*/
+
+#include "AcquisitionScheduler.h"
+#include <stdlib.h>
+
+long long switchesLeft;		// Shared countdown for the yield test
+long long lateTotal;		// Sum of wake-up lateness in the tick test
+long long lateMax;			// Worst wake-up lateness
+long long wakes;			// Number of tick wake-ups
+long long missedTicks;		// Ticks skipped, summed over the tickers
+
+SensorTask yielder(AcquisitionScheduler &s){
+	while (switchesLeft-- > 0){
+		co_await s.yield();
+	}
+}
+
+SensorTask ticker(AcquisitionScheduler &s, long long period, long long until){
+	Ticker tick(s, period);
+	long long expected = monotonicNanoseconds() + period;
+	while (expected < until){
+		long long skipped = co_await tick;
+		expected += skipped * period;
+		long long late = monotonicNanoseconds() - expected;
+		lateTotal += late;
+		if (late > lateMax){lateMax = late;}
+		wakes++;
+		expected += period;
+	}
+	missedTicks += tick.getMissed();
+}
+
+int main(int argc, char *argv[]){
+	int tasks = (argc > 1) ? atoi(argv[1]) : 8;
+	long long switches = (argc > 2) ? atoll(argv[2]) : 10000000;
+
+	// Yield ping-pong
+	{
+		AcquisitionScheduler s;
+		switchesLeft = switches;
+		for (int i = 0; i < tasks; i++){s.spawn(yielder(s));}
+		long long start = monotonicNanoseconds();
+		s.run();
+		long long end = monotonicNanoseconds();
+		printf("yield\t%d tasks\t%llu switches\t%.1f ns/switch\n", tasks,
+			s.getResumes(), (double)(end - start) / s.getResumes());
+	}
+
+	// Timer driven wake-ups
+	{
+		AcquisitionScheduler s;
+		long long period = 1000000;							// 1 ms
+		long long until = monotonicNanoseconds() + 1000000000LL;	// 1 s
+		for (int i = 0; i < tasks; i++){s.spawn(ticker(s, period, until));}
+		s.run();
+		printf("tick\t%d tasks\t%lld wakes\tlate mean %.1f us, max %.1f us\t%lld missed\n", tasks,
+			wakes, wakes ? lateTotal / 1e3 / wakes : 0.0, lateMax / 1e3, missedTicks);
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+/* Startup Benchmark
+
+	Times applying a full accelerometer configuration (the 13
+	registers of a profile, see LSM303Profile.h) four ways:
+
+		i2cset		one i2cset process per register, as SETUP.c does
+		per-byte	open, ioctl, write, close per register, as the
+					driver's writeI2CDeviceByte() used to
+		batched		one I2C_RDWR write transaction plus one
+					I2C_RDWR read-back, on a handle opened once
+		profile		the non-interactive SETUP path end to end:
+					load the profile file, validate, build, open
+					the bus, then the batched write and read-back
+
+	The profile line also reports the host-only part (load,
+	validate, build) separately, which runs without a bus.
+
+	Needs an I2C bus answering at 0x19 (the sensor, or the i2c-stub
+	module with chip_addr=0x19). The i2cset command can be replaced,
+	e.g. with "true" to measure only the process spawn floor.
+
+	Build:	g++ -O2 -I../Includes STARTUP.cpp -o STARTUP
+	Usage:	./STARTUP [bus] [i2cset command] [profile file]
+*/
+
+#include "I2CTransport.h"
+#include "LSM303Profile.h"
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ADDRESS 0x19	// LSM303 accelerometer
+
+/* elapsedMilliseconds function
+	Returns the milliseconds between two CLOCK_MONOTONIC readings.
+*/
+double elapsedMilliseconds(struct timespec start, struct timespec end){
+	return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+/* profileRegisters function
+	Flattens a profile into address/value pairs, the form the
+	per-register methods need. Returns the number of pairs.
+*/
+int profileRegisters(const profile &p, unsigned char *addresses, unsigned char *values){
+	int n = 0;
+	for (int i = 0; i < PROFILE_CTRL_COUNT; i++){
+		addresses[n] = CTRL_REG1_A + i;	values[n++] = p.ctrl[i];
+	}
+	addresses[n] = FIFO_CTRL_REG_A;		values[n++] = p.fifo_ctrl;
+	addresses[n] = INT1_CFG_A;			values[n++] = p.int1_cfg;
+	addresses[n] = INT1_THS_A;			values[n++] = p.int1_ths;
+	addresses[n] = INT1_THS_A + 1;		values[n++] = p.int1_duration;
+	addresses[n] = INT2_CFG_A;			values[n++] = p.int2_cfg;
+	addresses[n] = INT2_THS_A;			values[n++] = p.int2_ths;
+	addresses[n] = INT2_THS_A + 1;		values[n++] = p.int2_duration;
+	return n;
+}
+
+int main(int argc, char *argv[]){
+	int bus = (argc > 1) ? atoi(argv[1]) : 1;
+	const char *tool = (argc > 2) ? argv[2] : "i2cset";
+	const char *file = (argc > 3) ? argv[3] : "../Profiles/Default.txt";
+	struct timespec start, end;
+	unsigned char addresses[16], values[16];
+	char command[80];
+
+	profile p;
+	PROFILE_DEFAULT(&p);
+	p.ctrl[0] = 0x57;	// 100 Hz, all axes
+	int count = profileRegisters(p, addresses, values);
+
+	// One process per register
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < count; i++){
+		snprintf(command, sizeof(command), "%s -y %d %#x %#x %#x > /dev/null 2>&1", tool, bus, BENCH_ADDRESS, addresses[i], values[i]);
+		system(command);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("i2cset\t\t%d registers\t%.3f ms\n", count, elapsedMilliseconds(start, end));
+
+	// One handle per register
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int failed = 0;
+	for (int i = 0; i < count; i++){
+		I2CTransport transport(bus, BENCH_ADDRESS, false);
+		failed |= transport.writeRegister(addresses[i], values[i]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("per-byte\t%d registers\t%.3f ms%s\n", count, elapsedMilliseconds(start, end), failed ? "\t(failed)" : "");
+
+	// One transaction, plus one for read-back
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	I2CTransport transport(bus, BENCH_ADDRESS, false);
+	int applied = PROFILE_APPLY(transport.getHandle(), BENCH_ADDRESS, &p);
+	int verified = PROFILE_VERIFY(transport.getHandle(), BENCH_ADDRESS, &p);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("batched\t\t%d registers\t%.3f ms%s\n", count, elapsedMilliseconds(start, end),
+		(applied || verified) ? "\t(failed)" : "");
+
+	// Declarative profile, as SETUP -profile does it
+	struct timespec built;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	profile_spec spec;
+	PROFILE_SPEC_DEFAULT(&spec);
+	int loaded = PROFILE_LOAD(file, &spec);
+	const char *problem = PROFILE_VALIDATE(&spec);
+	PROFILE_BUILD(&spec, &p);
+	clock_gettime(CLOCK_MONOTONIC, &built);
+	I2CTransport setup(bus, BENCH_ADDRESS, false);
+	applied = PROFILE_APPLY(setup.getHandle(), BENCH_ADDRESS, &p);
+	verified = PROFILE_VERIFY(setup.getHandle(), BENCH_ADDRESS, &p);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (loaded != 0 || problem != NULL){
+		printf("profile\t\t%s could not be used\n", file);
+		return 1;
+	}
+	printf("profile\t\t%s\t%.3f ms (load, validate, build %.3f ms)%s\n", file,
+		elapsedMilliseconds(start, end), elapsedMilliseconds(start, built),
+		(applied || verified) ? "\t(failed)" : "");
+	return 0;
+}
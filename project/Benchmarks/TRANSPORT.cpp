@@ -0,0 +1,59 @@
+/* Transport Benchmark
+
+	Compares the old per-call bus handling (open, ioctl(I2C_SLAVE),
+	write, read, close for every sample) against the persistent
+	I2CTransport handle (write, read) for the same 128 byte read.
+
+	Runs without the sensor: by default the device is /dev/zero,
+	which accepts the address write and returns zeros, so the
+	numbers are pure syscall cost. Load the i2c-stub module and
+	pass its /dev/i2c-N node to include the kernel I2C path.
+
+	Build:	g++ -O2 -I../Includes TRANSPORT.cpp -o TRANSPORT
+	Usage:	./TRANSPORT [device] [reads]
+*/
+
+#include "I2CTransport.h"
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_BUFFER 0x80	// Same size as ADA10DOF_I2C_BUFFER
+#define BENCH_ADDRESS 0x19	// LSM303 accelerometer
+
+/* elapsedSeconds function
+	Returns the seconds between two CLOCK_MONOTONIC readings.
+*/
+double elapsedSeconds(struct timespec start, struct timespec end){
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]){
+	const char *device = (argc > 1) ? argv[1] : "/dev/zero";	// Stand-in device
+	long reads = (argc > 2) ? atol(argv[2]) : 100000;			// Reads per mode
+	char buffer[BENCH_BUFFER];
+	struct timespec start, end;
+
+	// Per-call handle, as readFullSensorState() used to do it
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < reads; i++){
+		I2CTransport transport(device, BENCH_ADDRESS, false);
+		transport.readRegisters(0x00, buffer, BENCH_BUFFER);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double perCall = reads / elapsedSeconds(start, end);
+
+	// Persistent handle, opened once
+	I2CTransport transport(device, BENCH_ADDRESS, false);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < reads; i++){
+		transport.readRegisters(0x00, buffer, BENCH_BUFFER);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double persistent = reads / elapsedSeconds(start, end);
+
+	printf("device\t\t%s\n", device);
+	printf("per-call\t%.0f reads/sec\n", perCall);
+	printf("persistent\t%.0f reads/sec\n", persistent);
+	printf("speedup\t\t%.2fx\n", persistent / perCall);
+	return 0;
+}
@@ -0,0 +1,250 @@
+/* Capture Import
+
+	Converts PrettyData.txt captures (READ.c's PDUMP, SESSIONS) and
+	the Test.txt files CONVERT.py makes from them into compressed
+	CaptureCodec.h captures, <name>.lsm next to each, which REPLAY,
+	PIPELINE and QUERY read in place of the text.
+
+		PrettyData	<sequence>	0x<X_L> 0x<X_H> 0x<Y_L> 0x<Y_H> 0x<Z_L> 0x<Z_H>
+		Test		<sequence> <X_L> <X_H> <Y_L> <Y_H> <Z_L> <Z_H>, signed decimal bytes
+
+	Both are told apart per field by the 0x, so either file works.
+	The text is mapped rather than read and parsed in place, field
+	by field, with no sscanf, locale or copy of the line; the blocks
+	go out through a CaptureWriter.h thread while the next ones are
+	parsed. Lines that do not parse (headers, a truncated last line)
+	are counted and skipped.
+
+	Neither format has times, so as in CaptureReplay.h they are
+	rebuilt from the sequence and the rate the capture was taken
+	at. A sequence that goes backwards starts a new run, one period
+	after the last sample, as when captures were appended.
+
+	Build:	g++ -std=c++11 -O2 -pthread -IIncludes IMPORT.cpp -o IMPORT
+	Usage:	IMPORT rate capture ...
+	e.g.	IMPORT 400 PrettyData.txt Test.txt
+*/
+
+#include "CaptureCodec.h"
+#include "CaptureWriter.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IMPORT_BYTES 6		// X_L through Z_H
+#define IMPORT_NOT_HEX 0xFF	// In IMPORT_HEX
+
+/* IMPORT_HEX table
+	Value of each character as a hex digit, IMPORT_NOT_HEX if it is
+	not one, so a digit costs one load and one compare.
+*/
+static unsigned char IMPORT_HEX[256];
+
+static void IMPORT_TABLE (){
+	memset(IMPORT_HEX, IMPORT_NOT_HEX, sizeof(IMPORT_HEX));
+	for (int d = 0; d < 10; d++){IMPORT_HEX['0' + d] = d;}
+	for (int d = 0; d < 6; d++){IMPORT_HEX['a' + d] = IMPORT_HEX['A' + d] = 10 + d;}
+}
+
+/* import structure
+	What one file held.
+*/
+struct import{
+	size_t size;					// Bytes of text
+	unsigned long long lines;		// Parsed into samples
+	unsigned long long skipped;		// Not a sample
+	unsigned long long runs;		// Sequence restarts, plus one
+	size_t encoded;					// Bytes written
+};
+typedef struct import import;	// Define type for import
+
+/* PARSE_UNSIGNED function
+	Reads decimal digits at p into value. Returns the character
+	after them, or NULL if there are none or too many.
+*/
+static inline const char *PARSE_UNSIGNED (const char *p, const char *end, uint32_t *value){
+	const char *start = p;
+	uint64_t v = 0;
+	unsigned d;
+	while (p < end && (d = IMPORT_HEX[(unsigned char)*p]) < 10 && p - start < 10){
+		v = v * 10 + d;
+		p++;
+	}
+	if (p == start || v > UINT32_MAX || (p < end && IMPORT_HEX[(unsigned char)*p] < 10)){return NULL;}
+	*value = (uint32_t)v;
+	return p;
+}
+
+/* PARSE_BYTE function
+	Reads one register byte at p, 0x<hex> as PDUMP writes it or a
+	decimal from -128 to 255 as CONVERT.py does. Returns the
+	character after it, or NULL.
+*/
+static inline const char *PARSE_BYTE (const char *p, const char *end, unsigned char *value){
+	if (end - p > 2 && p[0] == '0' && (p[1] | 0x20) == 'x'){
+		p += 2;
+		unsigned v = 0;
+		int digits = 0;
+		for (; p < end && digits < 3; p++, digits++){
+			unsigned d = IMPORT_HEX[(unsigned char)*p];
+			if (d == IMPORT_NOT_HEX){break;}
+			v = v << 4 | d;
+		}
+		if (digits == 0 || v > 0xFF){return NULL;}
+		*value = (unsigned char)v;
+		return p;
+	}
+	bool negative = (p < end && *p == '-');
+	p += negative;
+	unsigned v = 0;
+	int digits = 0;
+	for (; p < end && digits < 4; p++, digits++){
+		unsigned d = IMPORT_HEX[(unsigned char)*p];
+		if (d >= 10){break;}
+		v = v * 10 + d;
+	}
+	if (digits == 0 || v > (negative ? 128u : 255u)){return NULL;}
+	*value = (unsigned char)(negative ? -(int)v : (int)v);
+	return p;
+}
+
+/* PARSE_BLANKS function
+*/
+static inline const char *PARSE_BLANKS (const char *p, const char *end){
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')){p++;}
+	return p;
+}
+
+/* IMPORT function
+	Converts one capture. Returns 0, or -1 if it cannot be read or
+	the capture cannot be written.
+*/
+int IMPORT (const char *filename, double rate, import *result){
+	memset(result, 0, sizeof(*result));
+	int fd = open(filename, O_RDONLY | O_CLOEXEC);
+	struct stat status;
+	if (fd < 0 || fstat(fd, &status) != 0){
+		printf("Error: Trouble opening %s file.\n", filename);
+		if (fd >= 0){close(fd);}
+		return -1;
+	}
+	result->size = status.st_size;
+	const char *text = NULL;
+	if (result->size > 0){
+		void *map = mmap(NULL, result->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED){
+			printf("Error: Trouble mapping %s file.\n", filename);
+			close(fd);
+			return -1;
+		}
+		madvise(map, result->size, MADV_SEQUENTIAL);
+		text = (const char *)map;
+	}
+	close(fd);
+
+	char output[PATH_MAX];
+	const char *dot = strrchr(filename, '.');
+	const char *slash = strrchr(filename, '/');
+	int stem = (dot != NULL && (slash == NULL || dot > slash)) ? (int)(dot - filename) : (int)strlen(filename);
+	if (snprintf(output, sizeof(output), "%.*s.lsm", stem, filename) >= (int)sizeof(output)){
+		printf("Error: %s is too long a name.\n", filename);
+		if (text != NULL){munmap((void *)text, result->size);}
+		return -1;
+	}
+	CaptureWriter writer;
+	if (writer.open(output) != 0){
+		printf("Error: Trouble opening %s file.\n", output);
+		if (text != NULL){munmap((void *)text, result->size);}
+		return -1;
+	}
+
+	codec_sample block[CODEC_BLOCK];
+	unsigned char encoded[CODEC_MAX_BLOCK];
+	int pending = 0;
+	uint32_t first = 0, last = 0;
+	int64_t offset = 0, time = 0;
+	double period = 1e9 / rate;
+	const char *p = text, *end = text + result->size;
+	while (p < end){
+		const char *q = PARSE_BLANKS(p, end);
+		if (q == end || *q == '\n'){							// Blank line
+			p = q + 1;
+			continue;
+		}
+		uint32_t sequence;
+		unsigned char b[IMPORT_BYTES];
+		q = PARSE_UNSIGNED(q, end, &sequence);
+		for (int i = 0; i < IMPORT_BYTES && q != NULL; i++){
+			const char *field = PARSE_BLANKS(q, end);
+			q = (field > q) ? PARSE_BYTE(field, end, &b[i]) : NULL;		// Fields need a blank between them
+		}
+		if (q != NULL){q = PARSE_BLANKS(q, end);}
+		if (q == NULL || (q < end && *q != '\n')){				// Not a sample, skip the line
+			const char *next = (const char *)memchr(p, '\n', end - p);
+			p = (next != NULL) ? next + 1 : end;
+			result->skipped++;
+			continue;
+		}
+		p = q + 1;
+
+		if (result->lines == 0 || sequence < last){				// First sample of a run
+			if (result->lines > 0){offset = time + (int64_t)period;}
+			first = sequence;
+			result->runs++;
+		}
+		last = sequence;
+		time = offset + (int64_t)((sequence - first) * period);
+		codec_sample &sample = block[pending++];
+		sample.time = time;
+		sample.sequence = sequence;
+		for (int a = 0; a < 3; a++){sample.axis[a] = (int16_t)(b[2 * a] | b[2 * a + 1] << 8);}
+		if (pending == CODEC_BLOCK){
+			size_t size = CODEC_ENCODE(block, pending, encoded);
+			writer.write(encoded, size);
+			result->encoded += size;
+			pending = 0;
+		}
+		result->lines++;
+	}
+	if (pending > 0){
+		size_t size = CODEC_ENCODE(block, pending, encoded);
+		writer.write(encoded, size);
+		result->encoded += size;
+	}
+	if (text != NULL){munmap((void *)text, result->size);}
+	if (writer.close() != 0){
+		printf("Error: Trouble writing %s file.\n", output);
+		return -1;
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[]){
+	if (argc < 3 || atof(argv[1]) <= 0){
+		printf("Error: Expected the capture rate and at least one capture file.\n");	// Inform the user of the error
+		exit(1);																		// Exit with error
+	}
+	double rate = atof(argv[1]);
+	IMPORT_TABLE();
+
+	int failed = 0;
+	for (int i = 2; i < argc; i++){
+		import result;
+		struct timespec began, ended;
+		clock_gettime(CLOCK_MONOTONIC, &began);
+		if (IMPORT(argv[i], rate, &result) != 0){
+			failed++;
+			continue;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &ended);
+		double seconds = (ended.tv_sec - began.tv_sec) + (ended.tv_nsec - began.tv_nsec) / 1e9;
+		printf("%s\t%llu samples\t%llu skipped\t%llu runs\t%.1f MB in %.3f s\t%.1f MB/s\t%.2f bytes/sample\n",
+			argv[i], result.lines, result.skipped, result.runs, result.size / 1048576.0, seconds,
+			seconds > 0 ? result.size / 1048576.0 / seconds : 0.0,
+			result.lines ? (double)result.encoded / result.lines : 0.0);
+	}
+	return failed ? 1 : 0;	// TERMINATE MAIN PROGRAM
+}
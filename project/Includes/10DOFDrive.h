@@ -1,302 +1,629 @@
-/* Adafruit 10-DOF Header File
-	Austin H. Dial
-	4/20/2016
-
-	Contains all of the necessary functions and definitions
-	to carry out the communication between I2C devices on
-	a higher logical level. In other words it allows this
-	stuff to not crowd the actual data processing unit with
-	its lower level processes.
-*/
-
-
-#include "ADA10DOFAccelerometer.h"
-#include <linux/i2c-dev.h>
-#include <linux/i2c.h>
-#include <sys/ioctl.h>
-#include <stropts.h>
-#include <unistd.h>
-#include <unistd.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <fcntl.h>
-#include <math.h>
-
-#include <iostream>
-using namespace std;
-
-// Define variables to register address according to the datasheet
-#define ACC_X_LSB	0x28	// Map X-axis acceleration LSB to address 0x02
-#define ACC_X_MSB	0x29	// ...
-#define ACC_Y_LSB	0x2A	// ...
-#define ACC_Y_MSB	0x2B	// ...
-#define ACC_Z_LSB	0x2C	// ...
-#define ACC_Z_MSB	0x2C	// ...
-#define TEMP		0x31	// TEMP_OUT_H_M
-#define RANGE		0x01	// CRB_REG_M
-#define BANDWIDTH	0x20	// CTRL_REG1_A
-#define MODE_CONFIG	0x20	// CTRL_REG1_A
-
-#define MAX_BUS 0x80
-
-/* NOTES
-	The 0x20 resisters are used twice which ought not be possible, this
-	could result in critical system crashes of even corruption and there
-	-fore further research is diffinitively needed before operation.
-*/
-
-/* ADA10DOFAccelerometer function
-		Defines an instance of the accelerometer class and
-	takes attributes bus for the I2C bus and address for
-	the address of the device itself.
-	Upon instantiation the class calls the function 
-	ReadSensorState() to load the buffer.
-*/ 
-void ADA10DOFAccelerometer::ADA10Accelerometer(int bus, int address) {
-	I2CBus = bus;						// Set the attribute I2CBus of the class equal to the argument of the function
-	I2CAddress = address;				// ... for address
-	readFullSensorState();				// Call ReadFullSensorState
-}
-
-/* calculatePitchAndRoll function
-	Calculates the pitch and roll of the device using
-	the acceleration attributes.
-*/
-void ADA10DOFAccelerometer::calculatePitchAndRoll() {
-
-	double accelerationXSquared = this->accelerationX * this->accelerationX;
-	double accelerationYSquared = this->accelerationY * this->accelerationY;
-	double accelerationZSquared = this->accelerationZ * this->accelerationZ;
-	this->pitch = 180 * atan(accelerationX/sqrt(accelerationYSquared + accelerationZSquared))/M_PI;
-	this->roll = 180 * atan(accelerationY/sqrt(accelerationXSquared + accelerationZSquared))/M_PI;
-}
-
-/* readFullSensorState function
-	Refreshes the I2C bus information and 
-*/
-int ADA10DOFAccelerometer::readFullSensorState(){
-
-   //cout << "Starting BMA180 I2C sensor state read" << endl;
-    char namebuf[MAX_BUS];							// namebuffer of maximum allowed size
-   	snprintf(namebuf, sizeof(namebuf), "/dev/i2c-%d", I2CBus);		// Writes the string literal with the bus sent to it to namebuf
-    int file;									// File of type int
-    if ((file = open(namebuf, O_RDWR)) < 0){						// 
-            cout << "Failed to open BMA180 Sensor on " << namebuf << " I2C Bus" << endl;// 
-            return(1);									// 
-    }
-    if (ioctl(file, I2C_SLAVE, I2CAddress) < 0){					// 
-            cout << "I2C_SLAVE address " << I2CAddress << " failed..." << endl;		// 
-            return(2);									// 
-    }
-
-    // According to the BMA180 datasheet on page 59, you need to send the first address
-    // in write mode and then a stop/start condition is issued. Data bytes are
-    // transferred with automatic address increment.
-    char buf[1] = { 0x00 };								// 
-    if(write(file, buf, 1) !=1){							// 
-    	cout << "Failed to Reset Address in readFullSensorState() " << endl;		// 
-    }
-
-    int numberBytes = ADA10DOF_I2C_BUFFER;						// 
-    int bytesRead = read(file, this->dataBuffer, numberBytes);				// 
-    if (bytesRead == -1){								// 
-    	cout << "Failure to read Byte Stream in readFullSensorState()" << endl;		// 
-    }
-    close(file);									// 
-
-    if (this->dataBuffer[0]!=0x03){
-    	cout << "MAJOR FAILURE: DATA WITH BMA180 HAS LOST SYNC!" << endl;
-    }
-
-   // cout << "Number of bytes read was " << bytesRead << endl;
-   /// for (int i=0; i<8; i++){
-    //       printf("Byte %02d is 0x%02x\n", i, dataBuffer[i]);
-    //
-    //cout << "Closing BMA180 I2C sensor state read" << endl;
-
-    this->accelerationX = convertAcceleration(ACC_X_MSB, ACC_X_LSB);
-    this->accelerationY = convertAcceleration(ACC_Y_MSB, ACC_Y_LSB);
-    this->accelerationZ = convertAcceleration(ACC_Z_MSB, ACC_Z_LSB);
-    this->calculatePitchAndRoll();
-    //cout << "Pitch:" << this->getPitch() << "   Roll:" << this->getRoll() <<  endl;
-    return 0;
-}
-
-int ADA10DOFAccelerometer::convertAcceleration(int msb_reg_addr, int lsb_reg_addr){
-//	cout << "Converting " << (int) dataBuffer[msb_reg_addr] << " and " << (int) dataBuffer[lsb_reg_addr] << endl;;
-	short temp = dataBuffer[msb_reg_addr];
-	temp = (temp<<8) | dataBuffer[lsb_reg_addr];
-	temp = temp>>2;
-	temp = ~temp + 1;
-//	cout << "The X acceleration is " << temp << endl;
-	return temp;
-}
-
-void ADA10DOFAccelerometer::displayMode(int iterations){
-
-	for(int i=0; i<iterations; i++){
-		this->readFullSensorState();
-		printf("Rotation (%d, %d, %d)", accelerationX, accelerationY, accelerationZ);
-	}
-}
-
-//  Temperature in 2's complement has a resolution of 0.5K/LSB
-//  80h is lowest temp - approx -40C and 00000010 is 25C in 2's complement
-//  this value is offset at room temperature - 25C and accurate to 0.5K
-
-float ADA10DOFAccelerometer::getTemperature(){
-
-	int offset = -40;  // -40 degrees C
-	this->readFullSensorState();
-	char temp = dataBuffer[TEMP]; // = -80C 0b10000000  0b00000010; = +25C
-	//char temp = this->readI2CDeviceByte(TEMP);
-	//this->readFullSensorState();
-    //char temp = dataBuffer[TEMP];
-	int temperature;
-	if(temp&0x80)	{
-		temp = ~temp + 0b00000001;
-		temperature = 128 - temp;
-	}
-	else {
-		temperature = 128 + temp;
-	}
-	this->temperature = offset + ((float)temperature*0.5f);
-	//cout << "The temperature is " << this->temperature << endl;
-	//int temp_off = dataBuffer[0x37]>>1;
-	//cout << "Temperature offset raw value is: " << temp_off << endl;
-	return this->temperature;
-}
-
-ADA10_RANGE ADA10DOFAccelerometer::getRange(){
-	this->readFullSensorState();
-	char temp = dataBuffer[RANGE];
-	//char temp = this->readI2CDeviceByte(RANGE);  //bits 3,2,1
-	temp = temp & 0b00001110;
-	temp = temp>>1;
-	//cout << "The current range is: " << (int)temp << endl;
-	this->range = (ADA10_RANGE) temp;
-	return this->range;
-}
-
-int ADA10DOFAccelerometer::setRange(ADA10_RANGE range){
-	//char current = this->readI2CDeviceByte(RANGE);  //bits 3,2,1
-	this->readFullSensorState();
-	char current = dataBuffer[RANGE];
-	char temp = range << 1; //move value into bits 3,2,1
-	current = current & 0b11110001; //clear the current bits 3,2,1
-	temp = current | temp;
-	if(this->writeI2CDeviceByte(RANGE, temp)!=0){
-		cout << "Failure to update RANGE value" << endl;
-		return 1;
-	}
-	return 0;
-}
-
-ADA10_BANDWIDTH ADA10DOFAccelerometer::getBandwidth(){
-	this->readFullSensorState();
-	char temp = dataBuffer[BANDWIDTH];   //bits 7->4
-	//char temp = this->readI2CDeviceByte(BANDWIDTH);  //bits 7,6,5,4
-//	cout << "The value of bandwidth returned is: " << (int)temp << endl;
-	temp = temp & 0b11110000;
-	temp = temp>>4;
-//	cout << "The current bandwidth is: " << (int)temp << endl;
-	this->bandwidth = (ADA10_BANDWIDTH) temp;
-	return this->bandwidth;
-}
-
-int ADA10DOFAccelerometer::setBandwidth(ADA10_BANDWIDTH bandwidth){
-	//char current = this->readI2CDeviceByte(BANDWIDTH);  //bits 7,6,5,4
-	this->readFullSensorState();
-    char current = dataBuffer[BANDWIDTH];   //bits 7->4
-	char temp = bandwidth << 4; //move value into bits 7,6,5,4
-	current = current & 0b00001111; //clear the current bits 7,6,5,4
-	temp = current | temp;
-	if(this->writeI2CDeviceByte(BANDWIDTH, temp)!=0){
-		cout << "Failure to update BANDWIDTH value" << endl;
-		return 1;
-	}
-	return 0;
-}
-
-ADA10_MODECONFIG ADA10DOFAccelerometer::getModeConfig(){
-	//char temp = dataBuffer[MODE_CONFIG];   //bits 1,0
-	//char temp = this->readI2CDeviceByte(MODE_CONFIG);  //bits 1,0
-	this->readFullSensorState();
-    char temp = dataBuffer[MODE_CONFIG];
-	temp = temp & 0b00000011;
-	//cout << "The current mode config is: " << (int)temp << endl;
-	this->modeConfig = (ADA10_MODECONFIG) temp;
-	return this->modeConfig;
-}
-
-int ADA10DOFAccelerometer::writeI2CDeviceByte(char address, char value){
-
-    cout << "Starting BMA180 I2C sensor state write" << endl;
-    char namebuf[MAX_BUS];
-   	snprintf(namebuf, sizeof(namebuf), "/dev/i2c-%d", I2CBus);
-    int file;
-    if ((file = open(namebuf, O_RDWR)) < 0){
-            cout << "Failed to open BMA180 Sensor on " << namebuf << " I2C Bus" << endl;
-            return(1);
-    }
-    if (ioctl(file, I2C_SLAVE, I2CAddress) < 0){
-            cout << "I2C_SLAVE address " << I2CAddress << " failed..." << endl;
-            return(2);
-    }
-
-    // need to set the ctrl_reg0 ee_w bit. With that set the image registers change properly.
-    // need to do this or can't write to 20H ... 3Bh
-    // Very Important... wrote a 0x10 to 0x0D and it worked!!!
-    //   char buf[2];
-    //     buf[0] = BANDWIDTH;
-    //     buf[1] = 0x28;
-    //     buf[2] = 0x65;
-    //  if ( write(file,buf,2) != 2) {
-    //	  cout << "Failure to write values to I2C Device " << endl;
-    //  }
-
-    char buffer[2];
-    	buffer[0] = address;
-    	buffer[1] = value;
-    if ( write(file, buffer, 2) != 2) {
-        cout << "Failure to write values to I2C Device address." << endl;
-        return(3);
-    }
-    close(file);
-    cout << "Finished BMA180 I2C sensor state write" << endl;
-    return 0;
-}
-
-/* TRASHED FUNCTION
-char BMA180Accelerometer::readI2CDeviceByte(char address){
-
-  //  cout << "Starting BMA180 I2C sensor state byte read" << endl;
-    char namebuf[MAX_BUS];
-   	snprintf(namebuf, sizeof(namebuf), "/dev/i2c-%d", I2CBus);
-    int file;
-    if ((file = open(namebuf, O_RDWR)) < 0){
-            cout << "Failed to open BMA180 Sensor on " << namebuf << " I2C Bus" << endl;
-            return(1);
-    }
-    if (ioctl(file, I2C_SLAVE, I2CAddress) < 0){
-            cout << "I2C_SLAVE address " << I2CAddress << " failed..." << endl;
-            return(2);
-    }
-
-    // According to the BMA180 datasheet on page 59, you need to send the first address
-    // in write mode and then a stop/start condition is issued. Data bytes are
-    // transferred with automatic address increment.
-    char buf[1] = { 0x00 };
-    if(write(file, buf, 1) !=1){
-    	cout << "Failed to Reset Address in readFullSensorState() " << endl;
-    }
-
-    char buffer[1];
-    	buffer[0] = address;
-    if ( read(file, buffer, 2) != 2) {
-        cout << "Failure to read value from I2C Device address." << endl;
-    }
-    close(file);
-   // cout << "Finished BMA180 I2C sensor state read" << endl;
-    return buffer[0];
-}*/
\ No newline at end of file
+/* Adafruit 10-DOF Header File
+	Austin H. Dial
+	4/20/2016
+
+	Contains all of the necessary functions and definitions
+	to carry out the communication between I2C devices on
+	a higher logical level. In other words it allows this
+	stuff to not crowd the actual data processing unit with
+	its lower level processes.
+*/
+
+
+#ifndef ADA10DOFDRIVE_H_
+#define ADA10DOFDRIVE_H_
+
+#include "ADA10DOFAccelerometer.h"
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+
+#include <iostream>
+using namespace std;
+
+// Define variables to register address according to the datasheet
+#define ACC_X_LSB	0x28	// Map X-axis acceleration LSB to address 0x02
+#define ACC_X_MSB	0x29	// ...
+#define ACC_Y_LSB	0x2A	// ...
+#define ACC_Y_MSB	0x2B	// ...
+#define ACC_Z_LSB	0x2C	// ...
+#define ACC_Z_MSB	0x2D	// ...
+#define TEMP		0x31	// TEMP_OUT_H_M, on the magnetometer, TEMP_OUT_L_M follows
+#define TEMP_BYTES	2		// TEMP_OUT_H_M and TEMP_OUT_L_M
+#define MAG_ADDRESS	0x1E	// LSM303 magnetometer, the only device with TEMP
+#define CRA_REG_M	0x00	// TEMP_EN DO[2:0], on the magnetometer
+#define TEMP_EN		0x80	// CRA_REG_M, temperature sensor on
+#define RANGE		0x23	// CTRL_REG4_A, FS[1:0] in bits 5:4
+#define BANDWIDTH	0x20	// CTRL_REG1_A
+#define MODE_CONFIG	0x20	// CTRL_REG1_A, LPen in bit 3
+#define MODE_HR		0x08	// CTRL_REG4_A bit 3, high resolution
+#define MODE_LPEN	0x08	// CTRL_REG1_A bit 3, low power
+
+#define AUTO_INCREMENT	0x80	// Sub-address MSB, enables register auto-increment
+#define SAMPLE_BYTES	6		// OUT_X_L_A through OUT_Z_H_A
+
+#define MAX_BUS 0x80
+
+// Registers mirrored in configShadow, see refreshConfig()
+static const char configRegisters[] = { RANGE, BANDWIDTH };
+
+#define TEMP_PERIOD_DEFAULT	1000	// Milliseconds between temperature samples (1 Hz)
+#define TEMP_REFERENCE		25.0f	// Degrees C at which compensation is zero
+
+/* NOTES
+	The 0x20 resisters are used twice which ought not be possible, this
+	could result in critical system crashes of even corruption and there
+	-fore further research is diffinitively needed before operation.
+*/
+
+/* monotonicMilliseconds function
+	Returns CLOCK_MONOTONIC in milliseconds so that the temperature
+	schedule is not disturbed by changes to the wall clock.
+*/
+static long monotonicMilliseconds(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* pitchAndRoll function
+	Pitch and roll in degrees from the three acceleration counts,
+	the orientation step of decodeSample() on its own.
+*/
+static inline void pitchAndRoll(int x, int y, int z, double *pitch, double *roll){
+	double xSquared = (double)x * x;
+	double ySquared = (double)y * y;
+	double zSquared = (double)z * z;
+	*pitch = 180 * atan(x/sqrt(ySquared + zSquared))/M_PI;
+	*roll = 180 * atan(y/sqrt(xSquared + zSquared))/M_PI;
+}
+
+/* ADA10DOFAccelerometer function
+		Defines an instance of the accelerometer class and
+	takes attributes bus for the I2C bus and address for
+	the address of the device itself. The bus is opened
+	once here and stays open until the object is destroyed,
+	with reconnect choosing whether a failed transfer may
+	reopen it.
+	Upon instantiation the class calls the function 
+	ReadSensorState() to load the buffer.
+*/ 
+ADA10DOFAccelerometer::ADA10DOFAccelerometer(int bus, int address, bool reconnect) {
+	transport = new I2CTransport(bus, address, reconnect);	// Owned, see ~ADA10DOFAccelerometer
+	I2CBus = bus;						// Set the attribute I2CBus of the class equal to the argument of the function
+	I2CAddress = address;				// ... for address
+	initialize();
+}
+
+/* ADA10DOFAccelerometer function
+	Same as above on a transport supplied by the caller, e.g. a
+	SimulatedLSM303. The accelerometer takes ownership of it.
+*/
+ADA10DOFAccelerometer::ADA10DOFAccelerometer(I2CTransport *bus) {
+	transport = bus;
+	I2CBus = bus->getBus();
+	I2CAddress = bus->getAddress();
+	initialize();
+}
+
+/* initialize function
+	Common part of the constructors.
+*/
+void ADA10DOFAccelerometer::initialize() {
+	temperaturePeriod = TEMP_PERIOD_DEFAULT;	// Sample temperature once a second
+	temperatureSampledAt = -1;			// Force a temperature sample on the first read
+	temperatureTriedAt = -1;
+	setTemperatureCompensation(0.0f, 0.0f, 0.0f, TEMP_REFERENCE);	// No drift until coefficients are given
+	memset(configShadow, 0, sizeof(configShadow));	// Filled by refreshConfig below
+	LOSS_RESET(&loss);
+	fresh = false;
+	timestamp = 0;
+	fifoLeft = 0;
+	CLOCK_INIT(&sampleClock, 0);
+	enableTemperature();				// TEMP_OUT_M does not update without it
+	readFullSensorState();				// Call ReadFullSensorState
+	refreshConfig();					// Load the configuration shadow, starts the sample clock
+}
+
+/* restartClock function
+	The fit only holds for one ODR, so a new one is started
+	whenever the rate in the shadow differs from the fitted one.
+*/
+void ADA10DOFAccelerometer::restartClock() {
+	double rate = PROFILE_ODR_HZ(configShadow[CTRL_REG1_A]);
+	double nominal = rate > 0 ? 1e9 / rate : 0;
+	if (nominal != sampleClock.nominal){
+		CLOCK_INIT(&sampleClock, rate);
+		fifoLeft = 0;
+	}
+}
+
+/* ~ADA10DOFAccelerometer function
+	Deleting the transport closes the bus.
+*/
+ADA10DOFAccelerometer::~ADA10DOFAccelerometer() {
+	delete transport;
+}
+
+/* calculatePitchAndRoll function
+	Calculates the pitch and roll of the device using
+	the acceleration attributes.
+*/
+void ADA10DOFAccelerometer::calculatePitchAndRoll() {
+	pitchAndRoll(accelerationX, accelerationY, accelerationZ, &this->pitch, &this->roll);
+}
+
+/* readSample function
+	Fast path for acquisition. Reads STATUS_REG_A and OUT_X_L_A..
+	OUT_Z_H_A (0x27-0x2D) in one auto-increment burst into the
+	matching dataBuffer slots, so seven bytes cross the bus instead
+	of the full 128 byte dump. The status byte comes first in the
+	same transaction, so it describes exactly the data read with it
+	and feeds the loss counters and the sample clock. When the
+	temperature period has elapsed
+	the temperature registers are read as well, two bytes from the
+	magnetometer at MAG_ADDRESS (0x31 on the accelerometer is
+	INT1_SRC_A, which a read would clear), at most once per period
+	whether or not the read succeeds.
+*/
+int ADA10DOFAccelerometer::readSample(){
+
+    if (transport->ensureOpen() != 0){
+            return(1);
+    }
+
+    if (transport->readRegisters(STATUS_REG_A | AUTO_INCREMENT, this->dataBuffer + STATUS_REG_A, SAMPLE_BYTES + 1) != SAMPLE_BYTES + 1){
+    	cout << "Failure to read sample in readSample()" << endl;
+    	return(2);
+    }
+    long long host = SAMPLE_NOW();
+    unsigned char status = this->dataBuffer[STATUS_REG_A];
+    fresh = LOSS_STATUS(&loss, status);
+    if (fresh){
+    	unsigned long long index = CLOCK_OBSERVE(&sampleClock, host, 1, !(status & STATUS_ZYXOR));
+    	timestamp = CLOCK_STAMP(&sampleClock, index);
+    }
+
+    this->pollTemperature();
+    this->decodeSample();
+    return 0;
+}
+
+/* readFifo function
+	For FIFO and stream mode (FIFO_EN and FIFO_CTRL_REG_A set, see
+	LSM303Profile.h). Reads FIFO_SRC_REG_A, accounts overrun and
+	empty reads, then pops the unread samples one burst each, oldest
+	first. The newest sample in the FIFO arrived by the time
+	FIFO_SRC_REG_A was read, the others are stamped one fitted period
+	apart before it. Returns the number of samples stored or -1.
+*/
+int ADA10DOFAccelerometer::readFifo(AccelerationSample *samples, int max){
+
+    if (transport->ensureOpen() != 0){
+            return(-1);
+    }
+
+    if (transport->readRegisters(FIFO_SRC_REG_A, this->dataBuffer + FIFO_SRC_REG_A, 1) != 1){
+    	cout << "Failure to read FIFO_SRC_REG_A in readFifo()" << endl;
+    	return(-1);
+    }
+    long long host = SAMPLE_NOW();
+    unsigned char source = this->dataBuffer[FIFO_SRC_REG_A];
+    int available = LOSS_FIFO(&loss, source);
+    int count = available < max ? available : max;
+    int arrived = available > fifoLeft ? available - fifoLeft : 0;	// The rest were seen last time
+    unsigned long long newest = CLOCK_OBSERVE(&sampleClock, host, arrived, !(source & FIFO_SRC_OVRN));
+
+    for (int i = 0; i < count; i++){
+    	if (transport->readRegisters(ACC_X_LSB | AUTO_INCREMENT, this->dataBuffer + ACC_X_LSB, SAMPLE_BYTES) != SAMPLE_BYTES){
+    		fifoLeft = available - i;
+    		return(i);
+    	}
+    	timestamp = CLOCK_STAMP(&sampleClock, newest - (available - 1 - i));
+    	this->decodeSample();
+    	samples[i] = this->getSample();
+    }
+    fifoLeft = available - count;
+    fresh = count > 0;
+    return count;
+}
+
+/* decodeSample function
+	Converts the buffered acceleration registers, shared by
+	readSample() and readFullSensorState().
+*/
+void ADA10DOFAccelerometer::decodeSample(){
+    TRACE_SCOPE("decode");
+    this->accelerationX = convertAcceleration(ACC_X_MSB, ACC_X_LSB, temperatureDriftX);
+    this->accelerationY = convertAcceleration(ACC_Y_MSB, ACC_Y_LSB, temperatureDriftY);
+    this->accelerationZ = convertAcceleration(ACC_Z_MSB, ACC_Z_LSB, temperatureDriftZ);
+    this->calculatePitchAndRoll();
+}
+
+/* decodeSample function
+	Decodes six OUT_X_L_A..OUT_Z_H_A bytes that were read some
+	other way (an AcquisitionSession, a replayed capture) exactly as
+	readSample() would, without touching the bus.
+*/
+void ADA10DOFAccelerometer::decodeSample(const unsigned char *data){
+    memcpy(this->dataBuffer + ACC_X_LSB, data, SAMPLE_BYTES);
+    this->decodeSample();
+}
+
+/* readFullSensorState function
+	Diagnostic call: dumps the whole 128 byte register map into
+	dataBuffer and refreshes everything derived from it. Use
+	readSample() for acquisition.
+*/
+int ADA10DOFAccelerometer::readFullSensorState(){
+
+   //cout << "Starting BMA180 I2C sensor state read" << endl;
+    if (transport->ensureOpen() != 0){	// Bus is held open, only reopened if it was lost and reconnect is set
+            return(1);
+    }
+
+    // According to the BMA180 datasheet on page 59, you need to send the first address
+    // in write mode and then a stop/start condition is issued. Data bytes are
+    // transferred with automatic address increment.
+    int numberBytes = ADA10DOF_I2C_BUFFER;						// 
+    int bytesRead = transport->readRegisters(0x00, this->dataBuffer, numberBytes);	// 
+    if (bytesRead == -1){								// 
+    	cout << "Failure to read Byte Stream in readFullSensorState()" << endl;		// 
+    }
+
+    if (this->dataBuffer[0]!=0x03){
+    	cout << "MAJOR FAILURE: DATA WITH BMA180 HAS LOST SYNC!" << endl;
+    }
+
+   // cout << "Number of bytes read was " << bytesRead << endl;
+   /// for (int i=0; i<8; i++){
+    //       printf("Byte %02d is 0x%02x\n", i, dataBuffer[i]);
+    //
+    //cout << "Closing BMA180 I2C sensor state read" << endl;
+
+    this->pollTemperature();
+    this->decodeSample();
+    //cout << "Pitch:" << this->getPitch() << "   Roll:" << this->getRoll() <<  endl;
+    return 0;
+}
+
+/* convertAcceleration function
+	Assembles the two's complement reading from the buffer and
+	removes the temperature drift computed by updateTemperature().
+*/
+int ADA10DOFAccelerometer::convertAcceleration(int msb_reg_addr, int lsb_reg_addr, float drift){
+//	cout << "Converting " << (int) dataBuffer[msb_reg_addr] << " and " << (int) dataBuffer[lsb_reg_addr] << endl;;
+	short temp = dataBuffer[msb_reg_addr];
+	temp = (temp<<8) | (unsigned char)dataBuffer[lsb_reg_addr];	// LSB must not sign-extend
+	temp = temp>>2;
+	temp = ~temp + 1;
+//	cout << "The X acceleration is " << temp << endl;
+	if (drift == 0.0f){return temp;}	// Skip the float math when compensation is off
+	return (int)floorf((float)temp - drift + 0.5f);
+}
+
+void ADA10DOFAccelerometer::displayMode(int iterations){
+
+	for(int i=0; i<iterations; i++){
+		this->readSample();
+		printf("Rotation (%d, %d, %d)", accelerationX, accelerationY, accelerationZ);
+	}
+}
+
+//  TEMP_OUT_H_M and TEMP_OUT_L_M hold a 12-bit 2's complement value,
+//  left justified (the low nibble of TEMP_OUT_L_M is unused), at
+//  8 LSB per degree C
+
+/* updateTemperature function
+	Decodes the temperature bytes already sitting in temperatureData
+	when the temperature period has elapsed (or when forced) and
+	refreshes the per-axis drift used by convertAcceleration().
+*/
+void ADA10DOFAccelerometer::updateTemperature(bool force){
+
+	long now = monotonicMilliseconds();
+	if (!force && temperatureSampledAt >= 0 && now - temperatureSampledAt < temperaturePeriod){
+		return;	// Cached value is still fresh
+	}
+	temperatureSampledAt = now;
+
+	short temp = (short)((unsigned char)temperatureData[0] << 8 | (unsigned char)temperatureData[1]);
+	temp = temp>>4;	// Arithmetic shift keeps the sign
+	this->temperature = temp / 8.0f;
+
+	float delta = this->temperature - temperatureReference;
+	temperatureDriftX = temperatureCoeffX * delta;
+	temperatureDriftY = temperatureCoeffY * delta;
+	temperatureDriftZ = temperatureCoeffZ * delta;
+}
+
+/* getTemperature function
+	Returns the cached temperature. This never starts a bus
+	transaction, use sampleTemperature() to force a fresh value.
+*/
+float ADA10DOFAccelerometer::getTemperature(){
+	return this->temperature;
+}
+
+/* sampleTemperature function
+	Forces a temperature sample regardless of the schedule.
+	Only the magnetometer's temperature registers are read.
+*/
+int ADA10DOFAccelerometer::sampleTemperature(){
+	temperatureTriedAt = monotonicMilliseconds();
+	if (readTemperature() != 0){
+		cout << "Failure to read temperature in sampleTemperature()" << endl;
+		return 1;
+	}
+	this->updateTemperature(true);
+	return 0;
+}
+
+/* readTemperature function
+	TEMP_OUT_H_M and TEMP_OUT_L_M in one transaction, the
+	magnetometer increments its register pointer by itself.
+*/
+int ADA10DOFAccelerometer::readTemperature(){
+	return transport->readRegistersAt(MAG_ADDRESS, TEMP, this->temperatureData, TEMP_BYTES) == TEMP_BYTES ? 0 : 1;
+}
+
+/* pollTemperature function
+	Reads the temperature once its period has passed since the last
+	attempt. A failed read waits out the period like a good one, so
+	a missing magnetometer costs one transaction per period rather
+	than one per sample.
+*/
+void ADA10DOFAccelerometer::pollTemperature(){
+	long now = monotonicMilliseconds();
+	if (temperatureTriedAt >= 0 && now - temperatureTriedAt < temperaturePeriod){return;}
+	temperatureTriedAt = now;
+	if (readTemperature() == 0){
+		this->updateTemperature(true);
+	}
+}
+
+/* enableTemperature function
+	Sets TEMP_EN in CRA_REG_M, keeping the magnetometer's rate
+	bits, so TEMP_OUT_H_M and TEMP_OUT_L_M update.
+*/
+int ADA10DOFAccelerometer::enableTemperature(){
+	char cra;
+	if (transport->readRegistersAt(MAG_ADDRESS, CRA_REG_M, &cra, 1) != 1){
+		return 1;
+	}
+	if (cra & TEMP_EN){return 0;}
+	return transport->writeRegisterAt(MAG_ADDRESS, CRA_REG_M, cra | TEMP_EN) == 0 ? 0 : 1;
+}
+
+/* setTemperatureCompensation function
+	Sets the per-axis drift coefficients in LSB per degree C
+	relative to the reference temperature.
+*/
+void ADA10DOFAccelerometer::setTemperatureCompensation(float coeffX, float coeffY, float coeffZ, float reference){
+	temperatureCoeffX = coeffX;
+	temperatureCoeffY = coeffY;
+	temperatureCoeffZ = coeffZ;
+	temperatureReference = reference;
+
+	float delta = (temperatureSampledAt >= 0) ? this->temperature - reference : 0.0f;
+	temperatureDriftX = coeffX * delta;
+	temperatureDriftY = coeffY * delta;
+	temperatureDriftZ = coeffZ * delta;
+}
+
+/* setTemperaturePeriod function
+	Sets the minimum number of milliseconds between temperature
+	samples taken by readFullSensorState().
+*/
+void ADA10DOFAccelerometer::setTemperaturePeriod(long milliseconds){
+	temperaturePeriod = milliseconds;
+}
+
+/* refreshConfig function
+	Reloads the configuration register shadow from the device.
+	The getters below are answered from the shadow and the setters
+	write through it, so this is only needed if something else
+	(SETUP.c, i2cset, a reset) may have changed the device.
+*/
+int ADA10DOFAccelerometer::refreshConfig(){
+	for (unsigned int i = 0; i < sizeof(configRegisters); i++){
+		char value;
+		if (transport->readRegisters(configRegisters[i], &value, 1) != 1){
+			cout << "Failure to refresh configuration register " << (int)configRegisters[i] << endl;
+			return 1;
+		}
+		configShadow[(int)configRegisters[i]] = value;
+	}
+	restartClock();
+	return 0;
+}
+
+/* writeConfigRegister function
+	Writes a configuration register and, only if the write went
+	through, updates the shadow to match.
+*/
+int ADA10DOFAccelerometer::writeConfigRegister(char address, char value){
+	if(this->writeI2CDeviceByte(address, value)!=0){
+		return 1;
+	}
+	configShadow[(int)address] = value;
+	return 0;
+}
+
+/* applyProfile function
+	Applies a complete register profile (see LSM303Profile.h) in
+	one I2C_RDWR transaction and, unless told otherwise, reads it
+	all back in a second one. The shadow is updated on success so
+	the getters reflect the new configuration without a bus read.
+*/
+int ADA10DOFAccelerometer::applyProfile(const profile &p, bool verify){
+	if (transport->ensureOpen() != 0){
+		return 1;
+	}
+	if (PROFILE_APPLY_WITH(I2CTransport::profileTransfer, transport, I2CAddress, &p) != 0){
+		cout << "Failure to apply configuration profile" << endl;
+		return 2;
+	}
+	if (verify && PROFILE_VERIFY_WITH(I2CTransport::profileTransfer, transport, I2CAddress, &p) != 0){
+		cout << "Configuration profile did not verify" << endl;
+		refreshConfig();		// Shadow must match whatever the device really holds
+		return 3;
+	}
+
+	memcpy(configShadow + CTRL_REG1_A, p.ctrl, PROFILE_CTRL_COUNT);
+	configShadow[FIFO_CTRL_REG_A] = p.fifo_ctrl;
+	configShadow[INT1_CFG_A] = p.int1_cfg;
+	configShadow[INT1_THS_A] = p.int1_ths;
+	configShadow[INT1_THS_A + 1] = p.int1_duration;
+	configShadow[INT2_CFG_A] = p.int2_cfg;
+	configShadow[INT2_THS_A] = p.int2_ths;
+	configShadow[INT2_THS_A + 1] = p.int2_duration;
+	restartClock();
+	return 0;
+}
+
+ADA10_RANGE ADA10DOFAccelerometer::getRange(){
+	char temp = configShadow[RANGE];  //bits 5,4
+	temp = temp & 0b00110000;
+	temp = temp>>4;
+	//cout << "The current range is: " << (int)temp << endl;
+	this->range = (ADA10_RANGE) temp;
+	return this->range;
+}
+
+int ADA10DOFAccelerometer::setRange(ADA10_RANGE range){
+	char current = configShadow[RANGE];
+	char temp = range << 4; //move value into bits 5,4
+	current = current & 0b11001111; //clear the current bits 5,4
+	temp = current | temp;
+	if(this->writeConfigRegister(RANGE, temp)!=0){
+		cout << "Failure to update RANGE value" << endl;
+		return 1;
+	}
+	this->range = range;
+	return 0;
+}
+
+ADA10_BANDWIDTH ADA10DOFAccelerometer::getBandwidth(){
+	char temp = configShadow[BANDWIDTH];   //bits 7->4
+//	cout << "The value of bandwidth returned is: " << (int)temp << endl;
+	temp = temp & 0b11110000;
+	temp = (temp>>4) & 0b00001111;
+//	cout << "The current bandwidth is: " << (int)temp << endl;
+	this->bandwidth = (ADA10_BANDWIDTH) temp;
+	return this->bandwidth;
+}
+
+int ADA10DOFAccelerometer::setBandwidth(ADA10_BANDWIDTH bandwidth){
+    char current = configShadow[BANDWIDTH];   //bits 7->4
+	char temp = bandwidth << 4; //move value into bits 7,6,5,4
+	current = current & 0b00001111; //clear the current bits 7,6,5,4
+	temp = current | temp;
+	if(this->writeConfigRegister(BANDWIDTH, temp)!=0){
+		cout << "Failure to update BANDWIDTH value" << endl;
+		return 1;
+	}
+	this->bandwidth = bandwidth;
+	restartClock();
+	return 0;
+}
+
+/* getModeConfig function
+	The mode is split over two registers, LPen in CTRL_REG1_A and
+	HR in CTRL_REG4_A, both answered from the shadow.
+*/
+ADA10_MODECONFIG ADA10DOFAccelerometer::getModeConfig(){
+	if (configShadow[MODE_CONFIG] & MODE_LPEN){this->modeConfig = MODE_LOW_POWER;}
+	else if (configShadow[RANGE] & MODE_HR){this->modeConfig = MODE_LOW_NOISE;}
+	else {this->modeConfig = MODE_NORMAL;}
+	return this->modeConfig;
+}
+
+/* setModeConfig function
+	Writes LPen and HR, leaving the axis enables and the rest of
+	both registers as they are.
+*/
+int ADA10DOFAccelerometer::setModeConfig(ADA10_MODECONFIG mode){
+	char lowPower = configShadow[MODE_CONFIG] & ~MODE_LPEN;
+	char highRes = configShadow[RANGE] & ~MODE_HR;
+	if (mode == MODE_LOW_POWER){lowPower |= MODE_LPEN;}
+	if (mode == MODE_LOW_NOISE){highRes |= MODE_HR;}
+	if(this->writeConfigRegister(MODE_CONFIG, lowPower)!=0 || this->writeConfigRegister(RANGE, highRes)!=0){
+		cout << "Failure to update MODE_CONFIG value" << endl;
+		restartClock();
+		return 1;
+	}
+	this->modeConfig = mode;
+	restartClock();
+	return 0;
+}
+
+int ADA10DOFAccelerometer::writeI2CDeviceByte(char address, char value){
+
+    cout << "Starting BMA180 I2C sensor state write" << endl;
+    if (transport->ensureOpen() != 0){
+            return(1);
+    }
+
+    // need to set the ctrl_reg0 ee_w bit. With that set the image registers change properly.
+    // need to do this or can't write to 20H ... 3Bh
+    // Very Important... wrote a 0x10 to 0x0D and it worked!!!
+    //   char buf[2];
+    //     buf[0] = BANDWIDTH;
+    //     buf[1] = 0x28;
+    //     buf[2] = 0x65;
+    //  if ( write(file,buf,2) != 2) {
+    //	  cout << "Failure to write values to I2C Device " << endl;
+    //  }
+
+    if (transport->writeRegister(address, value) != 0) {
+        cout << "Failure to write values to I2C Device address." << endl;
+        return(3);
+    }
+    cout << "Finished BMA180 I2C sensor state write" << endl;
+    return 0;
+}
+
+/* TRASHED FUNCTION
+char BMA180Accelerometer::readI2CDeviceByte(char address){
+
+  //  cout << "Starting BMA180 I2C sensor state byte read" << endl;
+    char namebuf[MAX_BUS];
+   	snprintf(namebuf, sizeof(namebuf), "/dev/i2c-%d", I2CBus);
+    int file;
+    if ((file = open(namebuf, O_RDWR)) < 0){
+            cout << "Failed to open BMA180 Sensor on " << namebuf << " I2C Bus" << endl;
+            return(1);
+    }
+    if (ioctl(file, I2C_SLAVE, I2CAddress) < 0){
+            cout << "I2C_SLAVE address " << I2CAddress << " failed..." << endl;
+            return(2);
+    }
+
+    // According to the BMA180 datasheet on page 59, you need to send the first address
+    // in write mode and then a stop/start condition is issued. Data bytes are
+    // transferred with automatic address increment.
+    char buf[1] = { 0x00 };
+    if(write(file, buf, 1) !=1){
+    	cout << "Failed to Reset Address in readFullSensorState() " << endl;
+    }
+
+    char buffer[1];
+    	buffer[0] = address;
+    if ( read(file, buffer, 2) != 2) {
+        cout << "Failure to read value from I2C Device address." << endl;
+    }
+    close(file);
+   // cout << "Finished BMA180 I2C sensor state read" << endl;
+    return buffer[0];
+}*/
+
+#endif /* ADA10DOFDRIVE_H_ */
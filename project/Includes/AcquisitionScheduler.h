@@ -0,0 +1,321 @@
+/* Acquisition Scheduler Header File
+
+	Runs many periodic sampling tasks on one thread. Each task is a
+	C++20 coroutine that waits for its next tick or for a bus
+	transfer to complete, instead of a hand-written usleep loop
+	(READ.c, PARSE.c) or a thread per task. A single epoll loop
+	watches one timerfd, armed for the earliest deadline of all
+	tasks, and one eventfd on which the bus thread reports finished
+	transfers.
+
+	SensorTask sample(AcquisitionScheduler &s, AsyncAccelerometer &dev){
+		Ticker tick(s, 2500000);		// 400 Hz
+		while (true){
+			co_await tick;
+			int status = co_await s.transfer(dev, [](ADA10DOFAccelerometer &d){ return d.readSample(); });
+			...
+		}
+	}
+
+	Needs -std=c++20 -pthread.
+*/
+
+#ifndef ACQUISITIONSCHEDULER_H_
+#define ACQUISITIONSCHEDULER_H_
+
+#include "AsyncAccelerometer.h"
+
+#include <coroutine>
+#include <exception>
+#include <queue>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+/* monotonicNanoseconds function
+	CLOCK_MONOTONIC in nanoseconds, the scheduler's time base.
+*/
+static inline long long monotonicNanoseconds(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* SensorTask class definition
+	Return type of a scheduler coroutine. The coroutine starts
+	suspended and is owned by the scheduler once spawned.
+*/
+class SensorTask {
+
+	public:
+		struct promise_type {
+			SensorTask get_return_object() { return SensorTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		explicit SensorTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+		SensorTask(SensorTask &&other) : handle(other.handle) { other.handle = nullptr; }
+		~SensorTask() { if (handle){ handle.destroy(); } }
+
+		std::coroutine_handle<> release() { std::coroutine_handle<> h = handle; handle = nullptr; return h; }
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+
+		SensorTask(const SensorTask&);				// Not copyable
+		SensorTask& operator=(const SensorTask&);	// ...
+};
+
+class AcquisitionScheduler;
+
+/* Ticker class definition
+	Periodic deadline for one task. Deadlines advance by exactly one
+	period so the rate does not drift; a tick that is already late
+	is skipped and counted, co_await returns how many were missed.
+*/
+class Ticker {
+
+	private:
+		AcquisitionScheduler &scheduler;
+		long long period;						// Nanoseconds
+		long long deadline;						// Next absolute deadline
+		long long missed;						// Ticks skipped so far
+		long long missedNow;					// Ticks skipped by the current wait
+
+	public:
+		Ticker(AcquisitionScheduler &s, long long periodNanoseconds);
+
+		bool await_ready() { return false; }
+		void await_suspend(std::coroutine_handle<> h);
+		long long await_resume() { return missedNow; }
+
+		long long getMissed() { return missed; }
+		long long getPeriod() { return period; }
+};
+
+/* AcquisitionScheduler class definition
+	The event loop. Not thread-safe except for complete(), which
+	the bus thread uses to hand finished transfers back.
+*/
+class AcquisitionScheduler {
+
+	private:
+		struct Timer {
+			long long deadline;
+			std::coroutine_handle<> handle;
+			bool operator>(const Timer &other) const { return deadline > other.deadline; }
+		};
+
+		int epoll, timer, event;				// epoll, timerfd and eventfd handles
+		long long armedFor;						// Deadline the timerfd is set to, 0 if none
+		bool stopped;
+		int live;								// Spawned coroutines not yet finished
+		int inFlight;							// Transfers handed to a bus thread
+
+		std::deque<std::coroutine_handle<> > ready;
+		std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > timers;
+		std::mutex completedLock;				// Guards completed, written by bus threads
+		std::vector<std::coroutine_handle<> > completed;
+
+		unsigned long long resumes;				// Coroutine resumptions, for benchmarking
+
+		void resume(std::coroutine_handle<> h);
+		void armTimer();
+		void collect();
+
+		AcquisitionScheduler(const AcquisitionScheduler&);				// Not copyable
+		AcquisitionScheduler& operator=(const AcquisitionScheduler&);	// ...
+
+	public:
+		AcquisitionScheduler();
+		~AcquisitionScheduler();
+
+		void spawn(SensorTask task);			// Takes ownership, first resume happens in run()
+		void run();								// Until stop() or every task finished
+		void stop() { stopped = true; }
+
+		void wakeAt(long long deadline, std::coroutine_handle<> h);	// Used by Ticker
+		void wakeSoon(std::coroutine_handle<> h) { ready.push_back(h); }
+		void complete(std::coroutine_handle<> h);					// Any thread
+
+		unsigned long long getResumes() { return resumes; }
+
+		/* Yield awaitable
+			Lets every other ready task run once.
+		*/
+		struct Yield {
+			AcquisitionScheduler &scheduler;
+			bool await_ready() { return false; }
+			void await_suspend(std::coroutine_handle<> h) { scheduler.wakeSoon(h); }
+			void await_resume() {}
+		};
+		Yield yield() { return Yield{*this}; }
+
+		/* Transfer awaitable
+			Runs fn on the device's bus thread and resumes the task
+			with its result once the eventfd reports completion.
+		*/
+		struct Transfer {
+			AcquisitionScheduler &scheduler;
+			AsyncAccelerometer &device;
+			std::function<int(ADA10DOFAccelerometer&)> fn;
+			int result;
+
+			bool await_ready() { return false; }
+			void await_suspend(std::coroutine_handle<> h){
+				scheduler.inFlight++;
+				AcquisitionScheduler *owner = &scheduler;
+				device.submit<int>([this, owner, h](ADA10DOFAccelerometer &d){
+					int status = fn(d);
+					result = status;
+					owner->complete(h);				// May resume and free this frame, so nothing of this after it
+					return status;
+				});
+			}
+			int await_resume() { return result; }
+		};
+		Transfer transfer(AsyncAccelerometer &device, std::function<int(ADA10DOFAccelerometer&)> fn){
+			return Transfer{*this, device, fn, 0};
+		}
+};
+
+Ticker::Ticker(AcquisitionScheduler &s, long long periodNanoseconds)
+	: scheduler(s), period(periodNanoseconds), deadline(monotonicNanoseconds()),
+	  missed(0), missedNow(0) {
+}
+
+void Ticker::await_suspend(std::coroutine_handle<> h){
+	deadline += period;
+	long long now = monotonicNanoseconds();
+	missedNow = 0;
+	if (deadline < now){						// Late, skip to the next deadline still ahead
+		missedNow = (now - deadline) / period + 1;
+		deadline += missedNow * period;
+		missed += missedNow;
+	}
+	scheduler.wakeAt(deadline, h);
+}
+
+AcquisitionScheduler::AcquisitionScheduler()
+	: armedFor(0), stopped(false), live(0), inFlight(0), resumes(0) {
+	epoll = epoll_create1(EPOLL_CLOEXEC);
+	timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	struct epoll_event watch;
+	watch.events = EPOLLIN;
+	watch.data.fd = timer;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &watch);
+	watch.data.fd = event;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, event, &watch);
+}
+
+/* ~AcquisitionScheduler function
+	Destroys coroutines that never finished. Transfers still in
+	flight must have completed, i.e. the devices must outlive run().
+*/
+AcquisitionScheduler::~AcquisitionScheduler(){
+	while (!ready.empty()){ready.front().destroy(); ready.pop_front();}
+	while (!timers.empty()){timers.top().handle.destroy(); timers.pop();}
+	close(event);
+	close(timer);
+	close(epoll);
+}
+
+void AcquisitionScheduler::spawn(SensorTask task){
+	ready.push_back(task.release());
+	live++;
+}
+
+void AcquisitionScheduler::wakeAt(long long deadline, std::coroutine_handle<> h){
+	Timer t = { deadline, h };
+	timers.push(t);
+}
+
+void AcquisitionScheduler::complete(std::coroutine_handle<> h){
+	{
+		std::lock_guard<std::mutex> guard(completedLock);
+		completed.push_back(h);
+	}
+	uint64_t one = 1;
+	if (write(event, &one, sizeof(one)) != sizeof(one)){/*Counter full, loop is awake anyway*/}
+}
+
+void AcquisitionScheduler::resume(std::coroutine_handle<> h){
+	resumes++;
+	h.resume();
+	if (h.done()){
+		h.destroy();
+		live--;
+	}
+}
+
+/* armTimer function
+	Points the timerfd at the earliest deadline, only when it
+	changed, so a steady set of tasks costs no extra syscalls.
+*/
+void AcquisitionScheduler::armTimer(){
+	long long next = timers.empty() ? 0 : timers.top().deadline;
+	if (next == armedFor){return;}
+	struct itimerspec spec = {};
+	spec.it_value.tv_sec = next / 1000000000LL;
+	spec.it_value.tv_nsec = next % 1000000000LL;
+	timerfd_settime(timer, TFD_TIMER_ABSTIME, &spec, NULL);	// Zero disarms
+	armedFor = next;
+}
+
+/* collect function
+	Moves due timers and finished transfers to the ready queue.
+*/
+void AcquisitionScheduler::collect(){
+	long long now = monotonicNanoseconds();
+	while (!timers.empty() && timers.top().deadline <= now){
+		ready.push_back(timers.top().handle);
+		timers.pop();
+	}
+
+	std::lock_guard<std::mutex> guard(completedLock);
+	for (size_t i = 0; i < completed.size(); i++){
+		ready.push_back(completed[i]);
+		inFlight--;
+	}
+	completed.clear();
+}
+
+/* run function
+	Resumes ready tasks until none is ready, then sleeps in
+	epoll_wait until the next deadline or transfer completion.
+*/
+void AcquisitionScheduler::run(){
+	struct epoll_event events[2];
+	stopped = false;
+
+	while (!stopped && live > 0){
+		while (!ready.empty() && !stopped){
+			std::coroutine_handle<> h = ready.front();
+			ready.pop_front();
+			resume(h);
+		}
+		if (stopped || live == 0){break;}
+
+		collect();								// Anything already due needs no syscall
+		if (!ready.empty()){continue;}
+		if (timers.empty() && inFlight == 0){break;}	// Nothing can ever wake a task
+
+		armTimer();
+		int n = epoll_wait(epoll, events, 2, -1);
+		TRACE_INSTANT("scheduler wake", n);
+		for (int i = 0; i < n; i++){
+			uint64_t count;
+			if (read(events[i].data.fd, &count, sizeof(count)) < 0){/*Spurious wake*/}
+			if (events[i].data.fd == timer){armedFor = 0;}	// One-shot expired
+		}
+		collect();
+	}
+}
+
+#endif /* ACQUISITIONSCHEDULER_H_ */
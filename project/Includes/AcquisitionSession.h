@@ -0,0 +1,272 @@
+/* Acquisition Session Header File
+
+	READ.c keeps its stream in process globals (head, current,
+	read_count) and reads one device on one bus. Here that state
+	lives in an AcquisitionSession, one per sensor, and an
+	AcquisitionManager runs one worker thread per bus, each with its
+	own BusScheduler, so sensors on different buses are sampled in
+	parallel and throughput grows with the number of buses.
+
+	Each session fills its own ring buffer from its bus worker and
+	is drained by the application thread. A full ring drops the new
+	sample and counts it, the worker never waits on the consumer.
+
+	Every read starts at STATUS_REG_A, so the session knows whether
+	the sensor had a new sample (ZYXDA) and whether one was lost
+	before it (ZYXOR). Stale re-reads are counted and not stored.
+	Each sample is numbered and timed by a sample clock fitted to
+	the reads (SampleClock.h), so samples lost to an overrun leave
+	a gap of their size in the sequence and sampleTime is free of
+	the read jitter.
+
+	setTransportFactory() replaces the /dev/i2c-N handles, e.g. with
+	one SimulatedLSM303 per bus to run without hardware.
+
+	Ages at the decode, store and process stages go to pipelineLatency(),
+	see LatencyHistogram.h.
+
+	Needs -std=c++11 -pthread.
+*/
+
+#ifndef ACQUISITIONSESSION_H_
+#define ACQUISITIONSESSION_H_
+
+#include "BusScheduler.h"
+#include "LSM303Loss.h"
+#include "SampleClock.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define SESSION_SAMPLE_BYTES	6		// OUT_X_L_A through OUT_Z_H_A
+#define SESSION_READ_BYTES		7		// STATUS_REG_A, then the sample
+#define SESSION_CAPACITY		4096	// Samples buffered per sensor
+
+/* RawSample structure
+	One read of the six data registers, in register order, the
+	same bytes READ.c stores as X_L, X_H, Y_L, Y_H, Z_L, Z_H.
+*/
+struct RawSample {
+	long long timestamp;						// Release time, CLOCK_MONOTONIC nanoseconds
+	long long sampleTime;						// Fitted sensor time, CLOCK_MONOTONIC_RAW nanoseconds
+	unsigned int sequence;						// Sensor sample number + 1, replaces time_sig
+	unsigned char status;						// STATUS_REG_A read with the sample
+	unsigned char data[SESSION_SAMPLE_BYTES];
+};
+
+/* AcquisitionSession class definition
+	One sensor stream: where it is, how fast, and its buffer.
+	push() is called by exactly one bus worker and pop() by
+	exactly one consumer, which is all the ring supports.
+*/
+class AcquisitionSession {
+
+	private:
+		int I2CBus, I2CAddress;					// Where the sensor is
+		double rate;							// Samples per second
+		std::vector<RawSample> ring;			// Capacity + 1 slots, one always empty
+		std::atomic<size_t> head;				// Next slot to write, owned by the worker
+		std::atomic<size_t> tail;				// Next slot to read, owned by the consumer
+		std::atomic<unsigned long> produced;	// New samples read from the bus
+		std::atomic<unsigned long> dropped;		// Samples lost to a full ring
+		std::atomic<unsigned long> duplicates;	// Reads that found no new sample
+		std::atomic<unsigned long> overruns;	// Reads that found a sample overwritten
+		sample_clock clock;						// Worker-side, numbers and times the samples
+
+	public:
+		AcquisitionSession(int bus, int address, double rate, size_t capacity = SESSION_CAPACITY);
+
+		void   push(const char *data, long long timestamp, unsigned char status = STATUS_ZYXDA);	// Bus worker only
+		void   push(const char *data, long long timestamp, unsigned int sequence, long long sampleTime);	// Replay, keeps the capture's numbering
+		size_t pop(RawSample *out, size_t max);				// Consumer only
+		bool   full();											// Producer side, a push now would drop
+		void   setSensorRate(double odr) { CLOCK_INIT(&clock, odr); }	// Before start(), if not the read rate
+
+		int    getBus() { return I2CBus; }
+		int    getAddress() { return I2CAddress; }
+		double getRate() { return rate; }
+		unsigned long getProduced() { return produced; }
+		unsigned long getDropped() { return dropped; }
+		unsigned long getDuplicates() { return duplicates; }
+		unsigned long getOverruns() { return overruns; }
+		sample_clock getClock() { return clock; }		// Consistent once the worker has stopped
+};
+
+AcquisitionSession::AcquisitionSession(int bus, int address, double rate, size_t capacity)
+	: I2CBus(bus), I2CAddress(address), rate(rate), ring(capacity + 1),
+	  head(0), tail(0), produced(0), dropped(0), duplicates(0), overruns(0) {
+	CLOCK_INIT(&clock, rate);							// Assumes the sensor runs at the read rate
+}
+
+/* push function
+	status is the STATUS_REG_A byte read with the sample; sources
+	without one (replay) leave the default, a new sample. Called
+	right after the transfer, so the host time taken here is the
+	read time the sample clock is fitted to. An overrun makes the
+	sequence skip by the number of samples the fit says were lost.
+*/
+void AcquisitionSession::push(const char *data, long long timestamp, unsigned char status){
+	long long host = SAMPLE_NOW();
+	if (!(status & STATUS_ZYXDA)){
+		duplicates.fetch_add(1, std::memory_order_relaxed);	// Same sample as last time
+		return;
+	}
+	if (status & STATUS_ZYXOR){overruns.fetch_add(1, std::memory_order_relaxed);}
+	unsigned long long index = CLOCK_OBSERVE(&clock, host, 1, !(status & STATUS_ZYXOR));
+	pipelineLatency().mark(LATENCY_DECODE, timestamp);		// Status decoded, sample numbered and timed
+	size_t h = head.load(std::memory_order_relaxed);
+	size_t next = (h + 1) % ring.size();
+	produced.fetch_add(1, std::memory_order_relaxed);
+	if (next == tail.load(std::memory_order_acquire)){
+		dropped.fetch_add(1, std::memory_order_relaxed);	// Consumer is behind
+		return;
+	}
+	pipelineLatency().mark(LATENCY_STORE, timestamp);
+	RawSample &slot = ring[h];
+	slot.timestamp = timestamp;
+	slot.sampleTime = CLOCK_STAMP(&clock, index);
+	slot.sequence = (unsigned int)(index + 1);
+	slot.status = status;
+	memcpy(slot.data, data, SESSION_SAMPLE_BYTES);
+	head.store(next, std::memory_order_release);
+}
+
+/* push function
+	For sources that already number and time their samples, such
+	as a replayed capture: the sample is stored as given, so gaps in
+	the sequence stay gaps and the clock is left alone.
+*/
+void AcquisitionSession::push(const char *data, long long timestamp, unsigned int sequence, long long sampleTime){
+	size_t h = head.load(std::memory_order_relaxed);
+	size_t next = (h + 1) % ring.size();
+	produced.fetch_add(1, std::memory_order_relaxed);
+	if (next == tail.load(std::memory_order_acquire)){
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	pipelineLatency().mark(LATENCY_STORE, timestamp);
+	RawSample &slot = ring[h];
+	slot.timestamp = timestamp;
+	slot.sampleTime = sampleTime;
+	slot.sequence = sequence;
+	slot.status = STATUS_ZYXDA;
+	memcpy(slot.data, data, SESSION_SAMPLE_BYTES);
+	head.store(next, std::memory_order_release);
+}
+
+bool AcquisitionSession::full(){
+	size_t next = (head.load(std::memory_order_relaxed) + 1) % ring.size();
+	return next == tail.load(std::memory_order_acquire);
+}
+
+size_t AcquisitionSession::pop(RawSample *out, size_t max){
+	size_t t = tail.load(std::memory_order_relaxed);
+	size_t h = head.load(std::memory_order_acquire);
+	size_t n = 0;
+	long long now = (t != h && max > 0) ? latencyNow() : 0;	// One clock read per batch
+	while (t != h && n < max){
+		out[n++] = ring[t];
+		pipelineLatency().record(LATENCY_PROCESS, now - ring[t].timestamp);
+		t = (t + 1) % ring.size();
+	}
+	tail.store(t, std::memory_order_release);
+	return n;
+}
+
+/* AcquisitionManager class definition
+	Groups sessions by bus and runs one BusScheduler per bus on
+	its own thread between start() and stop().
+*/
+class AcquisitionManager {
+
+	private:
+		std::vector<std::unique_ptr<AcquisitionSession> > sessions;
+		std::map<int, std::unique_ptr<BusScheduler> > buses;	// One per bus number
+		std::vector<std::thread> workers;
+		std::function<I2CTransport*(int bus)> factory;		// NULL opens /dev/i2c-<bus>
+		long long startedAt, stoppedAt;
+
+		AcquisitionManager(const AcquisitionManager&);				// Not copyable
+		AcquisitionManager& operator=(const AcquisitionManager&);	// ...
+
+	public:
+		AcquisitionManager() : startedAt(0), stoppedAt(0) {}
+		~AcquisitionManager() { stop(); }
+
+		AcquisitionSession *addSession(int bus, int address, double rate);	// Before start()
+		void setTransportFactory(std::function<I2CTransport*(int bus)> make) { factory = make; }	// Before addSession()
+		void start();
+		void stop();
+
+		size_t getSessionCount() { return sessions.size(); }
+		AcquisitionSession *getSession(size_t i) { return sessions[i].get(); }
+		BusScheduler *getBus(int bus) { return buses.count(bus) ? buses[bus].get() : NULL; }
+		double getThroughput();				// Samples per second over all sessions
+};
+
+/* addSession function
+	Creates the session and a 7 byte auto-increment read job for
+	it on its bus' scheduler, which is created on first use.
+*/
+AcquisitionSession *AcquisitionManager::addSession(int bus, int address, double rate){
+	AcquisitionSession *session = new AcquisitionSession(bus, address, rate);
+	sessions.push_back(std::unique_ptr<AcquisitionSession>(session));
+
+	if (!buses.count(bus)){
+		buses[bus] = std::unique_ptr<BusScheduler>(factory ? new BusScheduler(factory(bus)) : new BusScheduler(bus));
+	}
+	buses[bus]->addJob("accelerometer", address, STATUS_REG_A | 0x80, SESSION_READ_BYTES, rate, 0,
+		[session](const char *data, int, long long released){ session->push(data + 1, released, data[0]); });
+	return session;
+}
+
+void AcquisitionManager::start(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	startedAt = (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+	stoppedAt = 0;
+
+	std::map<int, std::unique_ptr<BusScheduler> >::iterator it;
+	for (it = buses.begin(); it != buses.end(); ++it){
+		BusScheduler *scheduler = it->second.get();
+		int bus = it->first;
+		workers.push_back(std::thread([scheduler, bus]{
+			if (traceRecorder().isEnabled()){		// Label the worker in a trace
+				char name[TRACE_NAME_SIZE];
+				snprintf(name, sizeof(name), "bus %d", bus);
+				traceRecorder().nameThread(name);
+			}
+			scheduler->run(0);
+		}));
+	}
+}
+
+void AcquisitionManager::stop(){
+	if (workers.empty()){return;}
+	std::map<int, std::unique_ptr<BusScheduler> >::iterator it;
+	for (it = buses.begin(); it != buses.end(); ++it){it->second->stop();}
+	for (size_t i = 0; i < workers.size(); i++){workers[i].join();}
+	workers.clear();
+
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	stoppedAt = (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+double AcquisitionManager::getThroughput(){
+	if (startedAt == 0){return 0;}
+	long long end = stoppedAt;
+	if (end == 0){
+		struct timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		end = (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+	}
+	unsigned long total = 0;
+	for (size_t i = 0; i < sessions.size(); i++){total += sessions[i]->getProduced();}
+	return end > startedAt ? total * 1e9 / (end - startedAt) : 0;
+}
+
+#endif /* ACQUISITIONSESSION_H_ */
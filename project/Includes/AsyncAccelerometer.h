@@ -0,0 +1,220 @@
+/* Asynchronous Accelerometer Header File
+
+	Every ADA10DOFAccelerometer call blocks the caller for the whole
+	I2C transfer. AsyncAccelerometer moves the driver onto its own
+	bus-owner thread: reads and writes are queued and completed on
+	that thread, either through a std::future or a callback, so the
+	application threads can compute while the bus is busy.
+
+	Only the bus-owner thread ever touches the driver once the
+	constructor has returned. Callbacks also run on that thread and
+	should be short, anything slow delays the next transfer.
+
+	Needs -std=c++11 -pthread.
+*/
+
+#ifndef ASYNCACCELEROMETER_H_
+#define ASYNCACCELEROMETER_H_
+
+#include "10DOFDrive.h"
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <chrono>
+
+/* AsyncLatency structure
+	Completion latency, measured from the moment a request is
+	queued to the moment its result is delivered.
+*/
+struct AsyncLatency {
+	unsigned long completed;				// Requests completed so far
+	double meanMicroseconds;				// Average queue + transfer time
+	double maxMicroseconds;					// Worst queue + transfer time
+};
+
+/* AsyncSample structure
+	What a future from readSample() resolves to. sample is only a
+	new reading when status is 0, otherwise it is the last good one.
+*/
+struct AsyncSample {
+	int status;								// The driver's readSample() status
+	AccelerationSample sample;
+};
+
+/* AsyncAccelerometer class definition
+	Owns an ADA10DOFAccelerometer and the thread that drives it.
+*/
+class AsyncAccelerometer {
+
+	private:
+		typedef std::chrono::steady_clock clock;
+
+		struct Request {
+			std::function<void()> run;			// Work to do on the bus thread
+			clock::time_point queuedAt;			// For the latency statistics
+		};
+
+		ADA10DOFAccelerometer device;			// Only used by worker after construction
+		std::deque<Request> queue;				// Pending requests, oldest first
+		std::mutex lock;						// Guards queue, stopping and statistics
+		std::condition_variable wake;			// Signals the worker
+		bool stopping;							// Set by the destructor
+
+		unsigned long completed;				// Statistics, see AsyncLatency
+		double totalMicroseconds;
+		double maxMicroseconds;
+
+		std::thread worker;						// Bus-owner thread, started last
+
+		void run();								// Worker loop
+		void enqueue(std::function<void()> job);
+
+		AsyncAccelerometer(const AsyncAccelerometer&);				// Not copyable
+		AsyncAccelerometer& operator=(const AsyncAccelerometer&);	// ...
+
+	public:
+		AsyncAccelerometer(int bus, int address, bool reconnect = true);
+		AsyncAccelerometer(I2CTransport *bus);	// Takes ownership, e.g. a SimulatedLSM303
+		~AsyncAccelerometer();					// Finishes queued requests, then joins
+
+		// Generic request, fn runs on the bus thread with the driver
+		template <class Result>
+		std::future<Result> submit(std::function<Result(ADA10DOFAccelerometer&)> fn);
+
+		// Sample reads
+		std::future<AsyncSample> readSample();
+		void readSample(std::function<void(int status, const AccelerationSample&)> done);
+
+		// Configuration writes, resolve to the driver's status code
+		std::future<int> setRange(ADA10_RANGE range);
+		std::future<int> setBandwidth(ADA10_BANDWIDTH bandwidth);
+		std::future<int> setModeConfig(ADA10_MODECONFIG mode);
+		std::future<int> applyProfile(const profile &p, bool verify = true);
+
+		size_t queueDepth();					// Requests waiting for the bus
+		AsyncLatency getLatency();				// Completion latency so far
+};
+
+/* AsyncAccelerometer function
+	Opens the device on the calling thread, so a missing sensor is
+	reported here, then hands it to the bus-owner thread.
+*/
+AsyncAccelerometer::AsyncAccelerometer(int bus, int address, bool reconnect)
+	: device(bus, address, reconnect), stopping(false),
+	  completed(0), totalMicroseconds(0), maxMicroseconds(0) {
+	worker = std::thread(&AsyncAccelerometer::run, this);
+}
+
+AsyncAccelerometer::AsyncAccelerometer(I2CTransport *bus)
+	: device(bus), stopping(false),
+	  completed(0), totalMicroseconds(0), maxMicroseconds(0) {
+	worker = std::thread(&AsyncAccelerometer::run, this);
+}
+
+AsyncAccelerometer::~AsyncAccelerometer(){
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+void AsyncAccelerometer::enqueue(std::function<void()> job){
+	Request request;
+	request.run = job;
+	request.queuedAt = clock::now();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		queue.push_back(request);
+	}
+	wake.notify_one();
+}
+
+/* run function
+	Takes requests in order and runs them. The queue is drained
+	before the thread exits so that no future is left unresolved.
+*/
+void AsyncAccelerometer::run(){
+	std::unique_lock<std::mutex> guard(lock);
+	while (true){
+		wake.wait(guard, [this]{ return stopping || !queue.empty(); });
+		if (queue.empty()){
+			return;								// Stopping and nothing left
+		}
+		Request request = queue.front();
+		queue.pop_front();
+
+		guard.unlock();
+		request.run();							// Bus transfer happens here, unlocked
+		double micro = std::chrono::duration<double, std::micro>(clock::now() - request.queuedAt).count();
+		guard.lock();
+
+		completed++;
+		totalMicroseconds += micro;
+		if (micro > maxMicroseconds){maxMicroseconds = micro;}
+	}
+}
+
+template <class Result>
+std::future<Result> AsyncAccelerometer::submit(std::function<Result(ADA10DOFAccelerometer&)> fn){
+	std::shared_ptr<std::packaged_task<Result()> > task(
+		new std::packaged_task<Result()>(std::bind(fn, std::ref(device))));
+	std::future<Result> result = task->get_future();
+	enqueue([task]{ (*task)(); });
+	return result;
+}
+
+std::future<AsyncSample> AsyncAccelerometer::readSample(){
+	return submit<AsyncSample>([](ADA10DOFAccelerometer &d){
+		AsyncSample result;
+		result.status = d.readSample();
+		result.sample = d.getSample();
+		return result;
+	});
+}
+
+void AsyncAccelerometer::readSample(std::function<void(int status, const AccelerationSample&)> done){
+	enqueue([this, done]{
+		int status = device.readSample();
+		done(status, device.getSample());
+	});
+}
+
+std::future<int> AsyncAccelerometer::setRange(ADA10_RANGE range){
+	return submit<int>([range](ADA10DOFAccelerometer &d){ return d.setRange(range); });
+}
+
+std::future<int> AsyncAccelerometer::setBandwidth(ADA10_BANDWIDTH bandwidth){
+	return submit<int>([bandwidth](ADA10DOFAccelerometer &d){ return d.setBandwidth(bandwidth); });
+}
+
+std::future<int> AsyncAccelerometer::setModeConfig(ADA10_MODECONFIG mode){
+	return submit<int>([mode](ADA10DOFAccelerometer &d){ return d.setModeConfig(mode); });
+}
+
+std::future<int> AsyncAccelerometer::applyProfile(const profile &p, bool verify){
+	profile copy = p;	// The caller's profile may be gone by the time this runs
+	return submit<int>([copy, verify](ADA10DOFAccelerometer &d){ return d.applyProfile(copy, verify); });
+}
+
+size_t AsyncAccelerometer::queueDepth(){
+	std::lock_guard<std::mutex> guard(lock);
+	return queue.size();
+}
+
+AsyncLatency AsyncAccelerometer::getLatency(){
+	std::lock_guard<std::mutex> guard(lock);
+	AsyncLatency latency;
+	latency.completed = completed;
+	latency.meanMicroseconds = completed ? totalMicroseconds / completed : 0;
+	latency.maxMicroseconds = maxMicroseconds;
+	return latency;
+}
+
+#endif /* ASYNCACCELEROMETER_H_ */
@@ -0,0 +1,272 @@
+/* Bus Scheduler Header File
+
+	Shares one I2C bus between devices that need different rates,
+	e.g. on the 10-DOF board:
+
+		accelerometer	0x19	400 Hz
+		magnetometer	0x1E	75 Hz
+		barometer		0x77	10 Hz
+		temperature		0x1E	1 Hz
+
+	Time is cut into bus cycles as long as the shortest period.
+	At the start of every cycle the jobs whose release time has
+	come are ordered by priority, then by earliest deadline, and
+	issued as long as their estimated bus time fits in the cycle
+	budget. The rest wait for the next cycle; a job still waiting
+	when its deadline (release + period) passes is a deadline miss
+	and is released again for its next period.
+
+	All devices share one handle, each job is a single I2C_RDWR
+	transaction (see I2CTransport::readRegistersAt). The handle may
+	be any I2CTransport, SimulatedLSM303 included.
+*/
+
+#ifndef BUSSCHEDULER_H_
+#define BUSSCHEDULER_H_
+
+#include "I2CTransport.h"
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <time.h>
+
+#define BUS_JOB_BUFFER		0x20		// Largest read a job may ask for
+#define BUS_BUDGET_PERCENT	90			// Share of a cycle the planner may fill
+
+/* BusJob structure
+	One periodic read of a device, and what it has cost so far.
+*/
+struct BusJob {
+	const char *name;						// For the report
+	int address;							// 7-bit device address
+	char reg;								// First register, auto-increment bit included
+	int length;								// Bytes to read
+	char command[2];						// Optional register/value written after the read
+	int commandLength;						// 0 for none
+	long long period;						// Nanoseconds
+	int priority;							// Higher runs first within a cycle
+	std::function<void(const char *data, int length, long long released)> consumer;
+
+	long long released;						// Current release time
+	long long estimate;						// Estimated bus time in nanoseconds
+	unsigned long issued;					// Transactions completed
+	unsigned long failed;					// Transactions the bus refused
+	unsigned long missed;					// Releases dropped at their deadline
+	long long latencyTotal;					// Release to completion, nanoseconds
+	long long latencyMax;
+};
+
+/* BusScheduler class definition
+	Owns the bus handle and the job table.
+*/
+class BusScheduler {
+
+	private:
+		I2CTransport *transport;				// One handle for every device on the bus, owned
+		int busSpeed;							// Bits per second, for the estimates
+		std::vector<BusJob> jobs;
+		long long cycle;						// Cycle length, shortest period
+		long long started;						// When run() began
+		long long busy;							// Measured time spent in transfers
+		long long planned;						// Estimated time of issued transfers
+		unsigned long cycles;					// Cycles run
+		unsigned long overBudget;				// Cycles that left released jobs waiting
+		std::atomic<bool> stopping;				// Set by stop(), from any thread
+
+		static long long now();
+		long long estimateTransfer(const BusJob &job);
+		void runCycle();
+
+		BusScheduler(const BusScheduler&);				// Not copyable
+		BusScheduler& operator=(const BusScheduler&);	// ...
+
+	public:
+		BusScheduler(int bus, int speed = 100000);
+		BusScheduler(const char *path, int speed = 100000);	// Stand-in devices, see I2CTransport
+		BusScheduler(I2CTransport *bus, int speed = 100000);	// Takes ownership, e.g. a SimulatedLSM303
+		~BusScheduler() { delete transport; }
+
+		int  addJob(const char *name, int address, char reg, int length, double rate, int priority,
+					std::function<void(const char*, int, long long)> consumer = NULL);
+		void setCommand(int job, char reg, char value);	// Written after each read of job
+
+		void run(double seconds);				// Runs cycles until the time is up, or stop() if seconds <= 0
+		void stop() { stopping = true; }		// Ends run() after the current cycle
+		void report(FILE *out);					// Utilization and per-device misses
+
+		const BusJob &getJob(int job) { return jobs[job]; }
+		double getUtilization();				// Measured busy time over elapsed time
+};
+
+BusScheduler::BusScheduler(int bus, int speed)
+	: transport(new I2CTransport(bus, 0, true)), busSpeed(speed), cycle(0), started(0), busy(0), planned(0),
+	  cycles(0), overBudget(0), stopping(false) {
+}
+
+BusScheduler::BusScheduler(const char *path, int speed)
+	: transport(new I2CTransport(path, 0, true)), busSpeed(speed), cycle(0), started(0), busy(0), planned(0),
+	  cycles(0), overBudget(0), stopping(false) {
+}
+
+BusScheduler::BusScheduler(I2CTransport *bus, int speed)
+	: transport(bus), busSpeed(speed), cycle(0), started(0), busy(0), planned(0),
+	  cycles(0), overBudget(0), stopping(false) {
+}
+
+long long BusScheduler::now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* estimateTransfer function
+	Nine clocks per byte (eight bits and ACK) for the address and
+	register write, the repeated start, the address again and the
+	data, plus start and stop. Good enough to plan with.
+*/
+long long BusScheduler::estimateTransfer(const BusJob &job){
+	int bytes = 2 + 1 + job.length;			// addr+W, reg, addr+R, data
+	if (job.commandLength > 0){bytes += 1 + job.commandLength;}
+	long long bits = bytes * 9 + 4;			// Start, repeated start(s), stop
+	return bits * 1000000000LL / busSpeed;
+}
+
+/* addJob function
+	Registers a periodic read and returns its index. The cycle
+	shrinks to the shortest period given.
+*/
+int BusScheduler::addJob(const char *name, int address, char reg, int length, double rate, int priority,
+						 std::function<void(const char*, int, long long)> consumer){
+	BusJob job = {};
+	job.name = name;
+	job.address = address;
+	job.reg = reg;
+	job.length = std::min(length, BUS_JOB_BUFFER);
+	job.period = (long long)(1e9 / rate);
+	job.priority = priority;
+	job.consumer = consumer;
+	job.estimate = estimateTransfer(job);
+	jobs.push_back(job);
+
+	if (cycle == 0 || job.period < cycle){cycle = job.period;}
+	return jobs.size() - 1;
+}
+
+void BusScheduler::setCommand(int job, char reg, char value){
+	jobs[job].command[0] = reg;
+	jobs[job].command[1] = value;
+	jobs[job].commandLength = 2;
+	jobs[job].estimate = estimateTransfer(jobs[job]);
+}
+
+/* runCycle function
+	Plans and issues one cycle. Deadlines are tested against the
+	clock rather than the cycle's place on the grid, so a cycle
+	that starts late still counts the releases it is too late for.
+*/
+void BusScheduler::runCycle(){
+	long long start = now();
+	std::vector<BusJob*> due;
+	for (size_t i = 0; i < jobs.size(); i++){
+		BusJob &job = jobs[i];
+		while (job.released + job.period <= start){	// Deadline passed while waiting
+			job.missed++;
+			job.released += job.period;
+		}
+		if (job.released <= start){due.push_back(&job);}
+	}
+
+	std::sort(due.begin(), due.end(), [](const BusJob *a, const BusJob *b){
+		if (a->priority != b->priority){return a->priority > b->priority;}
+		return a->released + a->period < b->released + b->period;
+	});
+
+	long long budget = cycle * BUS_BUDGET_PERCENT / 100;
+	long long used = 0;
+	bool over = false;
+	for (size_t i = 0; i < due.size(); i++){
+		BusJob &job = *due[i];
+		if (used + job.estimate > budget){
+			if (!over){overBudget++;}
+			over = true;
+			if (used > 0){break;}					// Always issue at least one
+		}
+		used += job.estimate;
+
+		char data[BUS_JOB_BUFFER];
+		long long before = now();
+		int ret = transport->readRegistersAt(job.address, job.reg, data, job.length,
+											job.commandLength ? job.command : NULL, job.commandLength);
+		long long after = now();
+		busy += after - before;
+		planned += job.estimate;
+
+		if (ret == job.length){
+			job.issued++;
+			long long latency = after - job.released;
+			job.latencyTotal += latency;
+			if (latency > job.latencyMax){job.latencyMax = latency;}
+			pipelineLatency().record(LATENCY_BUS, latency);
+			if (job.consumer){job.consumer(data, job.length, job.released);}
+		}
+		else{
+			job.failed++;
+		}
+		job.released += job.period;				// Next release
+	}
+	cycles++;
+}
+
+/* run function
+	Sleeps to the start of each cycle with an absolute deadline,
+	so the cycle grid does not drift with the work done in it.
+	When the work overruns, the cycles already past are skipped
+	rather than run back to back; their releases are counted as
+	missed by runCycle. Ends on the clock, or with seconds <= 0
+	when another thread calls stop().
+*/
+void BusScheduler::run(double seconds){
+	if (jobs.empty()){return;}
+	started = now();
+	for (size_t i = 0; i < jobs.size(); i++){jobs[i].released = started;}
+
+	long long end = started + (long long)(seconds * 1e9);
+	long long start = started;
+	while (!stopping){
+		struct timespec wake;
+		wake.tv_sec = start / 1000000000LL;
+		wake.tv_nsec = start % 1000000000LL;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+		long long woke = now();
+		if (seconds > 0 && woke >= end){break;}
+		if (woke - start >= cycle){start += (woke - start) / cycle * cycle;}	// Behind, join the grid at now
+		TRACE_BEGIN("bus cycle");
+		runCycle();
+		TRACE_END("bus cycle");
+		start += cycle;
+	}
+}
+
+double BusScheduler::getUtilization(){
+	long long elapsed = now() - started;
+	return (started && elapsed > 0) ? (double)busy / elapsed : 0.0;
+}
+
+void BusScheduler::report(FILE *out){
+	long long elapsed = now() - started;
+	fprintf(out, "cycle %.3f ms, %lu cycles, %lu over budget\n", cycle / 1e6, cycles, overBudget);
+	fprintf(out, "bus utilization %.1f%% measured, %.1f%% estimated at %d Hz\n",
+		100.0 * getUtilization(), elapsed > 0 ? 100.0 * planned / elapsed : 0.0, busSpeed);
+	fprintf(out, "%-14s %8s %8s %8s %8s %10s %10s\n", "device", "rate", "issued", "failed", "missed", "mean us", "max us");
+	for (size_t i = 0; i < jobs.size(); i++){
+		const BusJob &job = jobs[i];
+		fprintf(out, "%-14s %8.1f %8lu %8lu %8lu %10.1f %10.1f\n", job.name, 1e9 / job.period,
+			job.issued, job.failed, job.missed,
+			job.issued ? job.latencyTotal / 1e3 / job.issued : 0.0, job.latencyMax / 1e3);
+	}
+}
+
+#endif /* BUSSCHEDULER_H_ */
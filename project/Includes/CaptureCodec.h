@@ -0,0 +1,385 @@
+/* Capture Codec Header File
+
+	Compressed binary captures. A PrettyData line spends about 35
+	bytes of text on six register bytes, and Timestamps another 20
+	on the time, while the acceleration barely moves from one sample
+	to the next at any useful ODR. This stores the same samples in a
+	few bytes each.
+
+	A capture is a sequence of blocks of up to CODEC_BLOCK samples.
+	Every block starts with the full first sample, so each decodes
+	on its own: a torn last block loses only its own samples, and a
+	reader can seek to any block. Within a block there are five
+	streams, one value per sample after the first:
+
+		sequence	step - 1, 0 unless samples were lost
+		time		step - previous step (delta of delta), 0 for a
+					steady clock, a few ns for fitted sample times
+		x, y, z		step of the raw 16 bit count, modulo 2^16
+
+	Each value is zigzag mapped, so small negative steps stay small
+	too, and the stream is bit-packed at the width of its largest
+	value. Trailing zero bits every axis step shares (the LSM303's
+	left justified 12 bit counts leave four) are shifted out first.
+	A stream that does not change costs nothing.
+
+	Block layout, little endian as on the BeagleBone and x86:
+
+		codec_header	CODEC_HEADER bytes, below
+		codec_summary	CODEC_SUMMARY bytes, if flags has CODEC_SUMMARIZED
+		sequence		ceil((count - 1) * width[0] / 8) bytes
+		time			... width[1]
+		x, y, z			... width[2..4]
+
+	The summary holds the block's time bounds and per axis minimum,
+	maximum and sum, so range queries (CaptureIndex.h) only decode
+	the blocks at the ends of the range. It costs under half a byte
+	a sample; blocks written before it existed have no flag and
+	still decode.
+
+	Decoding unpacks whole streams with unaligned 64 bit loads,
+	then runs the prefix sums over plain arrays, both loops free of
+	data-dependent branches.
+
+	The status byte of a sample is not kept; sequence gaps already
+	show the samples a read lost.
+
+	Plain C, shared by the C programs and the C++ sessions.
+*/
+
+#ifndef CAPTURECODEC_H_
+#define CAPTURECODEC_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODEC_MAGIC		0x424D534C		// "LSMB" in the file
+#define CODEC_VERSION	1
+#define CODEC_BLOCK		128				// Samples per block, at most
+#define CODEC_STREAMS	5				// sequence, time, x, y, z
+#define CODEC_HEADER	48				// sizeof(codec_header)
+#define CODEC_SUMMARY	48				// sizeof(codec_summary)
+#define CODEC_MAX_BLOCK	(CODEC_HEADER + CODEC_SUMMARY + (CODEC_BLOCK - 1) * (32 + 64 + 3 * 16) / 8 + CODEC_STREAMS)	// Largest encoded block
+#define CODEC_SUMMARIZED	0x01		// Header flag, a codec_summary follows
+
+/* codec_sample structure
+	One sample as the codec sees it. axis holds the raw register
+	pairs, X_L | X_H << 8 and so on, not yet shifted to 12 bits.
+*/
+struct codec_sample{
+	int64_t time;				// Nanoseconds, CLOCK_MONOTONIC_RAW for sessions
+	uint32_t sequence;			// Sample number
+	int16_t axis[3];			// X, Y, Z
+};
+typedef struct codec_sample codec_sample;	// Define type for codec_sample
+
+/* codec_header structure
+	Start of every block.
+*/
+struct codec_header{
+	uint32_t magic;				// CODEC_MAGIC
+	uint8_t version;			// CODEC_VERSION
+	uint8_t flags;				// CODEC_SUMMARIZED
+	uint16_t count;				// Samples in the block, 1 to CODEC_BLOCK
+	uint32_t bytes;				// After the header, summary and streams
+	uint32_t sequence;			// First sample
+	int64_t time;				// ...
+	int64_t period;				// Its first time step, what the deltas of deltas start from
+	int16_t first[3];			// ...
+	uint8_t width[CODEC_STREAMS];	// Bits per packed value
+	uint8_t shift[3];			// Trailing zero bits dropped from the axis steps
+	uint8_t spare[2];			// 0
+};
+typedef struct codec_header codec_header;	// Define type for codec_header
+
+/* codec_summary structure
+	What a range query needs of a block without decoding it. Axes
+	in raw counts, as in codec_sample.
+*/
+struct codec_summary{
+	int64_t low, high;			// Earliest and latest sample time
+	int32_t sum[3];				// Of each axis
+	int16_t min[3], max[3];		// ...
+	uint32_t peak;				// Largest x^2 + y^2 + z^2
+	uint32_t spare;				// 0
+};
+typedef struct codec_summary codec_summary;	// Define type for codec_summary
+
+typedef char CODEC_HEADER_SIZE[sizeof(codec_header) == CODEC_HEADER ? 1 : -1];	// Layout checks
+typedef char CODEC_SUMMARY_SIZE[sizeof(codec_summary) == CODEC_SUMMARY ? 1 : -1];	// ...
+
+/* CODEC_ZIGZAG functions
+	Signed to unsigned, 0 -1 1 -2 2 to 0 1 2 3 4, and back.
+*/
+static inline uint64_t CODEC_ZIGZAG (int64_t value){
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t CODEC_UNZIGZAG (uint64_t value){
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/* CODEC_WIDTH function
+	Bits needed for the largest of values, 0 if they are all 0.
+*/
+static inline int CODEC_WIDTH (uint64_t any){
+	return any ? 64 - __builtin_clzll(any) : 0;
+}
+
+/* CODEC_PACK function
+	Writes count values of width bits, lowest bit first, and returns
+	the end of what it wrote.
+*/
+static inline unsigned char *CODEC_PACK (unsigned char *out, const uint64_t *values, int count, int width){
+	if (width == 0){return out;}
+	uint64_t word = 0;
+	int used = 0;
+	for (int i = 0; i < count; i++){
+		word |= values[i] << used;
+		if (used + width >= 64){
+			memcpy(out, &word, 8);
+			out += 8;
+			word = used ? values[i] >> (64 - used) : 0;
+			used += width - 64;
+		}
+		else{used += width;}
+	}
+	for (; used > 0; used -= 8){
+		*out++ = (unsigned char)word;
+		word >>= 8;
+	}
+	return out;
+}
+
+/* CODEC_LOAD function
+	Eight bytes from byte on, zero past length.
+*/
+static inline uint64_t CODEC_LOAD (const unsigned char *in, size_t length, size_t byte){
+	uint64_t word = 0;
+	if (byte + 8 <= length){memcpy(&word, in + byte, 8);}
+	else if (byte < length){memcpy(&word, in + byte, length - byte);}
+	return word;
+}
+
+/* CODEC_UNPACK function
+	Reads count values of width bits from in, which holds length
+	bytes of the stream. Values whose eight byte load stays inside
+	the stream take the plain path, only the last few are padded.
+*/
+static inline void CODEC_UNPACK (const unsigned char *in, size_t length, uint64_t *values, int count, int width){
+	if (width == 0){
+		memset(values, 0, count * sizeof(uint64_t));
+		return;
+	}
+	uint64_t mask = width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+	int i = 0;
+	if (width <= 56 && length >= 8){
+		int fast = (int)(((length - 8) * 8) / width) + 1;	// Values starting in the first length - 7 bytes
+		if (fast > count){fast = count;}
+		for (size_t bit = 0; i < fast; i++, bit += width){
+			uint64_t word;
+			memcpy(&word, in + (bit >> 3), 8);
+			values[i] = (word >> (bit & 7)) & mask;
+		}
+	}
+	for (size_t bit = (size_t)i * width; i < count; i++, bit += width){
+		int offset = bit & 7;
+		uint64_t value = CODEC_LOAD(in, length, bit >> 3) >> offset;
+		if (offset + width > 64){value |= CODEC_LOAD(in, length, (bit >> 3) + 8) << (64 - offset);}	// Only past 57 bits
+		values[i] = value & mask;
+	}
+}
+
+/* CODEC_STREAM_BYTES function
+	Packed size of the values after the first of count samples.
+*/
+static inline size_t CODEC_STREAM_BYTES (int count, int width){
+	return ((size_t)(count - 1) * width + 7) / 8;
+}
+
+/* CODEC_SQUARE function
+	x^2 + y^2 + z^2 of a sample, for codec_summary.peak.
+*/
+static inline uint32_t CODEC_SQUARE (const codec_sample *sample){
+	uint32_t square = 0;
+	for (int a = 0; a < 3; a++){square += (uint32_t)((int32_t)sample->axis[a] * sample->axis[a]);}
+	return square;
+}
+
+/* CODEC_SUMMARIZE function
+	Summary of count samples, at least one.
+*/
+static inline void CODEC_SUMMARIZE (const codec_sample *samples, int count, codec_summary *summary){
+	memset(summary, 0, sizeof(*summary));
+	summary->low = summary->high = samples[0].time;
+	for (int a = 0; a < 3; a++){summary->min[a] = summary->max[a] = samples[0].axis[a];}
+	for (int i = 0; i < count; i++){
+		const codec_sample *s = &samples[i];
+		if (s->time < summary->low){summary->low = s->time;}
+		if (s->time > summary->high){summary->high = s->time;}
+		for (int a = 0; a < 3; a++){
+			summary->sum[a] += s->axis[a];
+			if (s->axis[a] < summary->min[a]){summary->min[a] = s->axis[a];}
+			if (s->axis[a] > summary->max[a]){summary->max[a] = s->axis[a];}
+		}
+		uint32_t square = CODEC_SQUARE(s);
+		if (square > summary->peak){summary->peak = square;}
+	}
+}
+
+/* CODEC_ENCODE function
+	Encodes count samples, 1 to CODEC_BLOCK, into one block of at
+	most CODEC_MAX_BLOCK bytes at out. Returns its size.
+*/
+static inline size_t CODEC_ENCODE (const codec_sample *samples, int count, unsigned char *out){
+	uint64_t streams[CODEC_STREAMS][CODEC_BLOCK];
+	codec_header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = CODEC_MAGIC;
+	header.version = CODEC_VERSION;
+	header.flags = CODEC_SUMMARIZED;
+	header.count = (uint16_t)count;
+	header.sequence = samples[0].sequence;
+	header.time = samples[0].time;
+	header.period = count > 1 ? samples[1].time - samples[0].time : 0;
+	for (int a = 0; a < 3; a++){header.first[a] = samples[0].axis[a];}
+
+	int n = count - 1;
+	int64_t step = header.period;
+	uint64_t any[CODEC_STREAMS] = {0, 0, 0, 0, 0};
+	for (int i = 0; i < n; i++){
+		const codec_sample *s = &samples[i + 1];
+		streams[0][i] = (uint32_t)(s->sequence - samples[i].sequence - 1);
+		int64_t next = s->time - samples[i].time;
+		streams[1][i] = CODEC_ZIGZAG(next - step);
+		step = next;
+		any[0] |= streams[0][i];
+		any[1] |= streams[1][i];
+	}
+	for (int a = 0; a < 3; a++){
+		int16_t steps[CODEC_BLOCK];
+		unsigned int zeros = 0;
+		for (int i = 0; i < n; i++){
+			steps[i] = (int16_t)(samples[i + 1].axis[a] - samples[i].axis[a]);	// Wraps, so it fits 16 bits
+			zeros |= (uint16_t)steps[i];
+		}
+		int shift = zeros ? __builtin_ctz(zeros) : 0;
+		header.shift[a] = (uint8_t)shift;
+		for (int i = 0; i < n; i++){
+			streams[2 + a][i] = CODEC_ZIGZAG(steps[i] >> shift);
+			any[2 + a] |= streams[2 + a][i];
+		}
+	}
+
+	unsigned char *payload = out + CODEC_HEADER;
+	codec_summary summary;
+	CODEC_SUMMARIZE(samples, count, &summary);
+	memcpy(payload, &summary, CODEC_SUMMARY);
+	unsigned char *end = payload + CODEC_SUMMARY;
+	for (int k = 0; k < CODEC_STREAMS; k++){
+		header.width[k] = (uint8_t)CODEC_WIDTH(any[k]);
+		end = CODEC_PACK(end, streams[k], n, header.width[k]);
+	}
+	header.bytes = (uint32_t)(end - payload);
+	memcpy(out, &header, CODEC_HEADER);
+	return CODEC_HEADER + header.bytes;
+}
+
+/* CODEC_CHECK function
+	Validates a block header, 0 if it can be decoded. The payload
+	size must match the widths exactly.
+*/
+static inline int CODEC_CHECK (const codec_header *header){
+	if (header->magic != CODEC_MAGIC || header->version != CODEC_VERSION){return -1;}
+	if (header->count < 1 || header->count > CODEC_BLOCK){return -1;}
+	if (header->flags & ~CODEC_SUMMARIZED){return -1;}
+	size_t bytes = (header->flags & CODEC_SUMMARIZED) ? CODEC_SUMMARY : 0;
+	for (int k = 0; k < CODEC_STREAMS; k++){
+		if (header->width[k] > (k == 0 ? 32 : k == 1 ? 64 : 16)){return -1;}
+		bytes += CODEC_STREAM_BYTES(header->count, header->width[k]);
+	}
+	for (int a = 0; a < 3; a++){
+		if (header->shift[a] > 15){return -1;}
+	}
+	return bytes == header->bytes ? 0 : -1;
+}
+
+/* CODEC_DECODE function
+	Decodes the block at in, size bytes available, into out, which
+	has room for CODEC_BLOCK samples. Returns the samples decoded,
+	or -1 if the block is damaged or cut short.
+*/
+static inline int CODEC_DECODE (const unsigned char *in, size_t size, codec_sample *out){
+	if (size < CODEC_HEADER){return -1;}
+	codec_header header;
+	memcpy(&header, in, CODEC_HEADER);
+	if (CODEC_CHECK(&header) != 0 || size < CODEC_HEADER + header.bytes){return -1;}
+
+	int count = header.count, n = count - 1;
+	uint64_t values[CODEC_BLOCK];
+	const unsigned char *stream = in + CODEC_HEADER + ((header.flags & CODEC_SUMMARIZED) ? CODEC_SUMMARY : 0);
+
+	out[0].sequence = header.sequence;
+	out[0].time = header.time;
+	for (int a = 0; a < 3; a++){out[0].axis[a] = header.first[a];}
+
+	size_t length = CODEC_STREAM_BYTES(count, header.width[0]);
+	CODEC_UNPACK(stream, length, values, n, header.width[0]);
+	uint32_t sequence = header.sequence;
+	for (int i = 0; i < n; i++){
+		sequence += (uint32_t)values[i] + 1;
+		out[i + 1].sequence = sequence;
+	}
+	stream += length;
+
+	length = CODEC_STREAM_BYTES(count, header.width[1]);
+	CODEC_UNPACK(stream, length, values, n, header.width[1]);
+	int64_t time = header.time, step = header.period;
+	for (int i = 0; i < n; i++){
+		step += CODEC_UNZIGZAG(values[i]);
+		time += step;
+		out[i + 1].time = time;
+	}
+	stream += length;
+
+	for (int a = 0; a < 3; a++){
+		length = CODEC_STREAM_BYTES(count, header.width[2 + a]);
+		CODEC_UNPACK(stream, length, values, n, header.width[2 + a]);
+		int shift = header.shift[a];
+		uint16_t value = (uint16_t)header.first[a];
+		for (int i = 0; i < n; i++){
+			value += (uint16_t)((uint16_t)CODEC_UNZIGZAG(values[i]) << shift);
+			out[i + 1].axis[a] = (int16_t)value;
+		}
+		stream += length;
+	}
+	return count;
+}
+
+/* CODEC_READ function
+	Reads the next block of a capture file into block, which has
+	room for CODEC_MAX_BLOCK bytes. Returns its size, 0 at the end
+	of the file, -1 if what follows is not a whole block.
+*/
+static inline int CODEC_READ (FILE *fpIN, unsigned char *block){
+	size_t got = fread(block, 1, CODEC_HEADER, fpIN);
+	if (got == 0){return 0;}
+	codec_header header;
+	memcpy(&header, block, CODEC_HEADER);
+	if (got < CODEC_HEADER || CODEC_CHECK(&header) != 0){return -1;}
+	if (fread(block + CODEC_HEADER, 1, header.bytes, fpIN) != header.bytes){return -1;}
+	return CODEC_HEADER + header.bytes;
+}
+
+/* CODEC_IS_CAPTURE function
+	1 if the file starts with a codec block, rewound either way.
+*/
+static inline int CODEC_IS_CAPTURE (FILE *fpIN){
+	uint32_t magic = 0;
+	size_t got = fread(&magic, 1, sizeof(magic), fpIN);
+	rewind(fpIN);
+	return got == sizeof(magic) && magic == CODEC_MAGIC;
+}
+
+#endif /* CAPTURECODEC_H_ */
@@ -0,0 +1,173 @@
+/* Capture Index Header File
+
+	Range queries over a compressed capture (CaptureCodec.h) without
+	decoding it. Opening a capture reads only the block headers and
+	summaries, one zone per block, skipping the packed streams. A
+	query then takes every block inside the range from its summary
+	and decodes only the blocks the range cuts through, normally the
+	first and the last, so its cost grows with the number of blocks
+	rather than samples.
+
+		capture_index index;
+		capture_range range;
+		INDEX_OPEN(&index, "Capture-2-0x19.lsm");
+		INDEX_QUERY(&index, from, to, &range);	// range.max[2], range.peak, ...
+		INDEX_CLOSE(&index);
+
+	Blocks written without a summary are decoded whenever they
+	overlap a range.
+
+	Plain C, shared by the C programs and the C++ sessions.
+*/
+
+#ifndef CAPTUREINDEX_H_
+#define CAPTUREINDEX_H_
+
+#include "CaptureCodec.h"
+
+#include <stdlib.h>
+
+/* capture_zone structure
+	Where a block is and what it holds.
+*/
+struct capture_zone{
+	long offset;				// Of the header in the file
+	uint16_t count;				// Samples
+	uint8_t summarized;			// summary is filled in
+	codec_summary summary;		// low and high are always filled in
+};
+typedef struct capture_zone capture_zone;	// Define type for capture_zone
+
+/* capture_index structure
+*/
+struct capture_index{
+	FILE *file;
+	capture_zone *zones;		// In file order
+	size_t count, capacity;		// ...
+	unsigned long long samples;	// In all zones
+	size_t decoded;				// Blocks the last query had to decode
+};
+typedef struct capture_index capture_index;	// Define type for capture_index
+
+/* capture_range structure
+	Aggregate of the samples in a time range, axes in raw counts.
+*/
+struct capture_range{
+	unsigned long long count;	// Samples, the rest is only valid if not 0
+	int64_t first, last;		// Earliest and latest sample time
+	int64_t sum[3];
+	int16_t min[3], max[3];
+	uint32_t peak;				// Largest x^2 + y^2 + z^2
+};
+typedef struct capture_range capture_range;	// Define type for capture_range
+
+/* INDEX_RANGE_MERGE function
+	Adds count samples summarised by summary to range.
+*/
+static inline void INDEX_RANGE_MERGE (capture_range *range, const codec_summary *summary, unsigned int count){
+	if (count == 0){return;}
+	if (range->count == 0){
+		range->first = summary->low;
+		range->last = summary->high;
+		for (int a = 0; a < 3; a++){
+			range->min[a] = summary->min[a];
+			range->max[a] = summary->max[a];
+		}
+	}
+	if (summary->low < range->first){range->first = summary->low;}
+	if (summary->high > range->last){range->last = summary->high;}
+	for (int a = 0; a < 3; a++){
+		range->sum[a] += summary->sum[a];
+		if (summary->min[a] < range->min[a]){range->min[a] = summary->min[a];}
+		if (summary->max[a] > range->max[a]){range->max[a] = summary->max[a];}
+	}
+	if (summary->peak > range->peak){range->peak = summary->peak;}
+	range->count += count;
+}
+
+/* INDEX_CLOSE function
+*/
+static inline void INDEX_CLOSE (capture_index *index){
+	if (index->file != NULL){fclose(index->file);}
+	free(index->zones);
+	memset(index, 0, sizeof(*index));
+}
+
+/* INDEX_OPEN function
+	Reads the zones of a capture. Returns the number of blocks, or
+	-1 if the file cannot be read; a damaged tail ends the index at
+	the last whole block.
+*/
+static inline int INDEX_OPEN (capture_index *index, const char *filename){
+	memset(index, 0, sizeof(*index));
+	index->file = fopen(filename, "r");
+	if (index->file == NULL){return -1;}
+
+	unsigned char block[CODEC_MAX_BLOCK];
+	codec_sample samples[CODEC_BLOCK];
+	codec_header header;
+	long offset = 0;
+	while (fread(&header, 1, CODEC_HEADER, index->file) == CODEC_HEADER && CODEC_CHECK(&header) == 0){
+		capture_zone zone;
+		memset(&zone, 0, sizeof(zone));
+		zone.offset = offset;
+		zone.count = header.count;
+		if (header.flags & CODEC_SUMMARIZED){
+			if (fread(&zone.summary, 1, CODEC_SUMMARY, index->file) != CODEC_SUMMARY){break;}
+			if (fseek(index->file, header.bytes - CODEC_SUMMARY, SEEK_CUR) != 0){break;}
+			zone.summarized = 1;
+		}
+		else{													// Old block, decode it for its time bounds
+			memcpy(block, &header, CODEC_HEADER);
+			if (fread(block + CODEC_HEADER, 1, header.bytes, index->file) != header.bytes){break;}
+			if (CODEC_DECODE(block, CODEC_HEADER + header.bytes, samples) < 0){break;}
+			CODEC_SUMMARIZE(samples, header.count, &zone.summary);
+		}
+		if (index->count == index->capacity){
+			size_t capacity = index->capacity ? 2 * index->capacity : 1024;
+			capture_zone *zones = (capture_zone *)realloc(index->zones, capacity * sizeof(capture_zone));
+			if (zones == NULL){break;}
+			index->zones = zones;
+			index->capacity = capacity;
+		}
+		index->zones[index->count++] = zone;
+		index->samples += header.count;
+		offset += CODEC_HEADER + header.bytes;
+	}
+	return (int)index->count;
+}
+
+/* INDEX_QUERY function
+	Aggregates the samples from from to to, both included, into
+	range. Returns how many there were, or -1 if a block that had
+	to be decoded could not be read.
+*/
+static inline long long INDEX_QUERY (capture_index *index, int64_t from, int64_t to, capture_range *range){
+	memset(range, 0, sizeof(*range));
+	index->decoded = 0;
+	unsigned char block[CODEC_MAX_BLOCK];
+	codec_sample samples[CODEC_BLOCK];
+	for (size_t z = 0; z < index->count; z++){
+		const capture_zone *zone = &index->zones[z];
+		if (zone->summary.high < from || zone->summary.low > to){continue;}	// Outside
+		if (zone->summarized && zone->summary.low >= from && zone->summary.high <= to){
+			INDEX_RANGE_MERGE(range, &zone->summary, zone->count);		// Inside, summary only
+			continue;
+		}
+
+		if (fseek(index->file, zone->offset, SEEK_SET) != 0){return -1;}	// Cut by the range
+		int size = CODEC_READ(index->file, block);
+		int n = size > 0 ? CODEC_DECODE(block, size, samples) : -1;
+		if (n < 0){return -1;}
+		index->decoded++;
+		for (int i = 0; i < n; i++){
+			if (samples[i].time < from || samples[i].time > to){continue;}
+			codec_summary one;
+			CODEC_SUMMARIZE(&samples[i], 1, &one);
+			INDEX_RANGE_MERGE(range, &one, 1);
+		}
+	}
+	return (long long)range->count;
+}
+
+#endif /* CAPTUREINDEX_H_ */
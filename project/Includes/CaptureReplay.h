@@ -0,0 +1,243 @@
+/* Capture Replay Header File
+
+	Feeds a saved capture into an AcquisitionSession as if it were
+	coming off the bus, so the processing side can be changed and
+	measured without recording the motion again. The consumer pops
+	RawSamples from the session exactly as it does during live
+	acquisition.
+
+	Captures are the PrettyData format written by READ.c (PDUMP) and
+	SESSIONS, one sample per line in register order:
+
+		<sequence>	0x<X_L> 0x<X_H> 0x<Y_L> 0x<Y_H> 0x<Z_L> 0x<Z_H>
+
+	The format has no timestamps, so sample times are rebuilt from
+	the sequence number and the rate the capture was taken at. Gaps
+	in the sequence stay gaps.
+
+	Compressed captures (CaptureCodec.h, SESSIONS -compress) are
+	recognised by their first bytes and keep their own sample times.
+
+	Pacing, set by speed:
+		1.0				real time, samples are released at their
+						original spacing
+		N				N times faster
+		REPLAY_UNPACED	as fast as possible; the replay waits for
+						ring space instead of dropping, so every
+						sample reaches the consumer
+
+	Paced replay drops on a full ring, like a bus worker does.
+	Timestamps always follow the capture's own timeline (replay
+	start plus the original offset) so that time deltas seen by the
+	processing do not change with the speed.
+
+	Needs -std=c++11 -pthread.
+*/
+
+#ifndef CAPTUREREPLAY_H_
+#define CAPTUREREPLAY_H_
+
+#include "AcquisitionSession.h"
+#include "CaptureCodec.h"
+
+#include <sched.h>
+
+#define REPLAY_UNPACED		0.0		// Speed for as fast as possible
+#define REPLAY_LINE			128		// Longest capture line
+
+/* CaptureReplay class definition
+	Holds a capture in memory and the thread that replays it.
+*/
+class CaptureReplay {
+
+	private:
+		std::vector<RawSample> samples;			// Timestamps relative to the first sample
+		double rate;							// Capture rate, samples per second
+		double speed;							// See notes, REPLAY_UNPACED for no pacing
+		int repeat;								// Passes over the capture
+		AcquisitionSession *session;			// Destination, not owned
+		std::thread worker;
+		std::atomic<bool> stopping;
+		std::atomic<bool> finished;
+		std::atomic<unsigned long> fed;			// Samples handed to the session
+		std::atomic<long long> startedAt;		// CLOCK_MONOTONIC nanoseconds, written by the worker
+		std::atomic<long long> finishedAt;		// ...
+
+		static long long now();
+		int  loadCompressed(FILE *fpIN);
+		void run();
+
+		CaptureReplay(const CaptureReplay&);				// Not copyable
+		CaptureReplay& operator=(const CaptureReplay&);	// ...
+
+	public:
+		CaptureReplay(double rate, double speed = 1.0);
+		~CaptureReplay() { stop(); }
+
+		int  load(const char *filename);		// Appends a capture file, returns samples read or -1
+		void add(const RawSample &sample);		// Appends one sample, timestamp relative to the first
+		void setRepeat(int passes) { repeat = passes; }
+
+		void start(AcquisitionSession *destination);	// Replays on its own thread
+		void stop();							// Ends early and joins
+		void wait();							// Joins once the capture is done
+
+		bool   isFinished() { return finished; }
+		size_t getLoaded() { return samples.size(); }
+		unsigned long getFed() { return fed; }
+		double getElapsed();					// Seconds of replay so far
+		double getAchievedSpeed();				// Capture seconds per replay second
+};
+
+CaptureReplay::CaptureReplay(double rate, double speed)
+	: rate(rate), speed(speed), repeat(1), session(NULL), stopping(false), finished(false),
+	  fed(0), startedAt(0), finishedAt(0) {
+}
+
+long long CaptureReplay::now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* load function
+	Reads a PrettyData capture. Lines that do not parse (headers,
+	a truncated last line) are skipped.
+*/
+int CaptureReplay::load(const char *filename){
+	FILE *fpIN = fopen(filename, "r");
+	if (fpIN == NULL){
+		printf("Error: Trouble opening %s file.\n", filename);
+		return -1;
+	}
+
+	if (CODEC_IS_CAPTURE(fpIN)){
+		int count = loadCompressed(fpIN);
+		fclose(fpIN);
+		if (count < 0){printf("Error: %s is damaged after %zu samples.\n", filename, samples.size());}
+		return count;
+	}
+
+	char line[REPLAY_LINE];
+	unsigned int first = 0;
+	bool haveFirst = !samples.empty();
+	long long offset = haveFirst ? samples.back().timestamp + (long long)(1e9 / rate) : 0;	// Appended after what is loaded
+	int count = 0;
+	while (fgets(line, sizeof(line), fpIN) != NULL){
+		unsigned int sequence, b[SESSION_SAMPLE_BYTES];
+		if (sscanf(line, "%u %x %x %x %x %x %x", &sequence, &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 7){
+			continue;
+		}
+		if (count == 0){first = sequence;}
+		RawSample sample;
+		sample.sequence = sequence;
+		sample.status = STATUS_ZYXDA;
+		sample.timestamp = offset + (long long)((sequence - first) * 1e9 / rate);
+		sample.sampleTime = sample.timestamp;
+		for (int i = 0; i < SESSION_SAMPLE_BYTES; i++){sample.data[i] = (unsigned char)b[i];}
+		samples.push_back(sample);
+		count++;
+	}
+	fclose(fpIN);
+	return count;
+}
+
+/* loadCompressed function
+	Reads the blocks of a compressed capture. Returns samples read,
+	or -1 at a damaged block, keeping the samples before it.
+*/
+int CaptureReplay::loadCompressed(FILE *fpIN){
+	unsigned char block[CODEC_MAX_BLOCK];
+	codec_sample decoded[CODEC_BLOCK];
+	long long offset = samples.empty() ? 0 : samples.back().timestamp + (long long)(1e9 / rate);
+	long long first = 0;
+	int count = 0, size;
+	while ((size = CODEC_READ(fpIN, block)) > 0){
+		int n = CODEC_DECODE(block, size, decoded);
+		if (n < 0){return -1;}
+		if (count == 0){first = decoded[0].time;}
+		for (int i = 0; i < n; i++){
+			RawSample sample;
+			sample.sequence = decoded[i].sequence;
+			sample.status = STATUS_ZYXDA;
+			sample.timestamp = offset + (decoded[i].time - first);
+			sample.sampleTime = decoded[i].time;
+			for (int a = 0; a < 3; a++){
+				sample.data[2 * a] = (unsigned char)decoded[i].axis[a];
+				sample.data[2 * a + 1] = (unsigned char)((uint16_t)decoded[i].axis[a] >> 8);
+			}
+			samples.push_back(sample);
+		}
+		count += n;
+	}
+	return size < 0 ? -1 : count;
+}
+
+void CaptureReplay::add(const RawSample &sample){
+	samples.push_back(sample);
+}
+
+void CaptureReplay::start(AcquisitionSession *destination){
+	session = destination;
+	stopping = false;
+	finished = false;
+	fed = 0;
+	worker = std::thread(&CaptureReplay::run, this);
+}
+
+void CaptureReplay::stop(){
+	stopping = true;
+	if (worker.joinable()){worker.join();}
+}
+
+void CaptureReplay::wait(){
+	if (worker.joinable()){worker.join();}
+}
+
+/* run function
+	Releases each sample at startedAt + offset / speed with an
+	absolute sleep, so pacing errors do not accumulate.
+*/
+void CaptureReplay::run(){
+	long long started = now();
+	finishedAt = 0;
+	startedAt = started;
+	long long span = samples.empty() ? 0 : samples.back().timestamp + (long long)(1e9 / rate);
+	unsigned int stride = samples.empty() ? 0 : samples.back().sequence - samples.front().sequence + 1;	// Later passes carry on after the last
+
+	for (int pass = 0; pass < repeat && !stopping; pass++){
+		for (size_t i = 0; i < samples.size() && !stopping; i++){
+			long long captured = pass * span + samples[i].timestamp;
+			if (speed > 0){
+				long long release = started + (long long)(captured / speed);
+				if (release > now()){
+					struct timespec wake;
+					wake.tv_sec = release / 1000000000LL;
+					wake.tv_nsec = release % 1000000000LL;
+					clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+				}
+			}
+			else{
+				while (session->full() && !stopping){sched_yield();}	// Backpressure, never drop
+			}
+			const RawSample &sample = samples[i];
+			session->push((const char *)sample.data, started + captured, sample.sequence + pass * stride, sample.sampleTime + pass * span);
+			fed.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	finishedAt = now();
+	finished = true;
+}
+
+double CaptureReplay::getElapsed(){
+	long long started = startedAt, finished = finishedAt;
+	if (started == 0){return 0;}
+	return ((finished ? finished : now()) - started) / 1e9;
+}
+
+double CaptureReplay::getAchievedSpeed(){
+	double elapsed = getElapsed();
+	return elapsed > 0 ? (fed / rate) / elapsed : 0;
+}
+
+#endif /* CAPTUREREPLAY_H_ */
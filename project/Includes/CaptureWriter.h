@@ -0,0 +1,376 @@
+/* Capture Writer Header File
+
+	Moves file writes off the thread that drains the sensors. A
+	write() only copies into one of a few large, page-aligned
+	buffers; a buffer that fills is queued for the writer's own
+	thread, which takes every buffer queued by then and writes them
+	with one writev(). While the card is stalled the producer keeps
+	filling the next buffer, so a stall costs it nothing until every
+	buffer is waiting.
+
+	Full buffers are a whole number of WRITER_ALIGN pages, so the
+	file grows by whole pages. A buffer older than maxAge is handed
+	over early, but only up to its last whole page; the rest goes
+	into the next buffer. Only close() writes a partial page.
+
+	When every buffer is queued the producer waits for one, counted
+	as a stall, or with dropWhenFull the write is dropped whole and
+	counted instead, so a compressed block is never cut.
+
+		CaptureWriter writer;
+		writer.open("Capture-2-0x19.lsm");
+		writer.write(block, size);				// From the draining thread
+		writer.close();
+		writer.report(stdout);					// Throughput, queue depth, stalls
+
+	Needs -std=c++11 -pthread.
+*/
+
+#ifndef CAPTUREWRITER_H_
+#define CAPTUREWRITER_H_
+
+#include "TraceRecorder.h"
+
+#include <condition_variable>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define WRITER_ALIGN	4096			// Page of the card and the page cache
+#define WRITER_BUFFER	(256 * 1024)	// Bytes per buffer, rounded up to WRITER_ALIGN
+#define WRITER_BUFFERS	4				// Buffers per writer, at least two
+#define WRITER_AGE		1.0				// Seconds a partly filled buffer may wait
+
+/* CaptureWriter class definition
+	One output file, its buffers and the thread that writes them.
+*/
+class CaptureWriter {
+
+	private:
+		struct Buffer {
+			unsigned char *data;				// WRITER_ALIGN aligned, size bytes
+			size_t used;
+		};
+
+		std::vector<Buffer> buffers;
+		size_t size;							// Of each buffer
+		bool dropWhenFull;						// Drop writes instead of waiting for a buffer
+		long long maxAge;						// Nanoseconds, 0 to hand over only full buffers
+		int fd;
+		int filling;							// Buffer write() copies into, -1 for none yet
+		long long filledSince;					// When its first byte arrived
+
+		std::thread worker;
+		std::mutex lock;						// Guards everything below
+		std::condition_variable queued;			// full has a buffer or stopping is set
+		std::condition_variable freed;			// spare has a buffer
+		std::deque<int> full;					// Waiting for the thread, oldest first
+		std::vector<int> spare;
+		int writing;							// Buffers in the writev() under way
+		bool stopping;
+
+		unsigned long long bytes;				// Written to the file
+		unsigned long writes;					// writev() calls
+		unsigned long handed;					// Buffers queued
+		unsigned long depthTotal;				// Queue depth summed over each handover
+		int maxDepth;
+		unsigned long stalls;					// Writes that waited for a buffer
+		long long stallTime;					// Nanoseconds spent waiting
+		unsigned long dropped;					// Writes dropped with dropWhenFull
+		unsigned long long droppedBytes;
+		unsigned long errors;					// Failed writev() calls, their buffers are lost
+		long long writeTime;					// Nanoseconds in writev()
+		long long longestWrite;					// ...
+
+		static long long now();
+		bool hand(bool everything);
+		int  take();
+		void run();
+
+		CaptureWriter(const CaptureWriter&);				// Not copyable
+		CaptureWriter& operator=(const CaptureWriter&);	// ...
+
+	public:
+		CaptureWriter(size_t bufferSize = WRITER_BUFFER, int bufferCount = WRITER_BUFFERS,
+			bool dropWhenFull = false, double maxAge = WRITER_AGE);
+		~CaptureWriter();
+
+		int  open(const char *filename);		// Creates or truncates it and starts the thread, 0 on success
+		bool write(const void *data, size_t length);	// false if dropped
+		void flush();							// Hands over the whole pages written so far
+		int  close();							// Writes the rest, syncs and joins, 0 if nothing was lost
+
+		unsigned long long getBytes() { std::lock_guard<std::mutex> g(lock); return bytes; }
+		unsigned long getWrites() { std::lock_guard<std::mutex> g(lock); return writes; }
+		int  getDepth() { std::lock_guard<std::mutex> g(lock); return (int)full.size() + writing; }
+		int  getMaxDepth() { std::lock_guard<std::mutex> g(lock); return maxDepth; }
+		unsigned long getStalls() { std::lock_guard<std::mutex> g(lock); return stalls; }
+		unsigned long getDropped() { std::lock_guard<std::mutex> g(lock); return dropped; }
+		unsigned long getErrors() { std::lock_guard<std::mutex> g(lock); return errors; }
+		double getThroughput();					// Bytes per second of writev()
+		void report(FILE *out);					// One line of the above
+};
+
+CaptureWriter::CaptureWriter(size_t bufferSize, int bufferCount, bool drop, double age)
+	: size((bufferSize + WRITER_ALIGN - 1) / WRITER_ALIGN * WRITER_ALIGN), dropWhenFull(drop),
+	  maxAge((long long)(age * 1e9)), fd(-1), filling(-1), filledSince(0), writing(0), stopping(false),
+	  bytes(0), writes(0), handed(0), depthTotal(0), maxDepth(0), stalls(0), stallTime(0),
+	  dropped(0), droppedBytes(0), errors(0), writeTime(0), longestWrite(0) {
+	if (size == 0){size = WRITER_ALIGN;}
+	if (bufferCount < 2){bufferCount = 2;}
+	buffers.resize(bufferCount);
+	for (int b = 0; b < bufferCount; b++){
+		void *data = NULL;
+		if (posix_memalign(&data, WRITER_ALIGN, size) != 0){data = NULL;}
+		buffers[b].data = (unsigned char *)data;
+		buffers[b].used = 0;
+	}
+}
+
+CaptureWriter::~CaptureWriter(){
+	close();
+	for (size_t b = 0; b < buffers.size(); b++){free(buffers[b].data);}
+}
+
+long long CaptureWriter::now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* open function
+*/
+int CaptureWriter::open(const char *filename){
+	if (fd >= 0){return -1;}
+	for (size_t b = 0; b < buffers.size(); b++){
+		if (buffers[b].data == NULL){return -1;}
+	}
+	fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0){return -1;}
+
+	full.clear();
+	spare.clear();
+	for (int b = (int)buffers.size() - 1; b >= 0; b--){
+		buffers[b].used = 0;
+		spare.push_back(b);
+	}
+	filling = -1;
+	stopping = false;
+	worker = std::thread(&CaptureWriter::run, this);
+	return 0;
+}
+
+/* take function
+	Takes a spare buffer for the producer, waiting for the thread
+	to free one if there is none.
+*/
+int CaptureWriter::take(){
+	std::unique_lock<std::mutex> guard(lock);
+	if (spare.empty()){
+		TRACE_SCOPE("writer stall");
+		long long began = now();
+		freed.wait(guard, [this]{ return !spare.empty(); });
+		stalls++;
+		stallTime += now() - began;
+	}
+	int b = spare.back();
+	spare.pop_back();
+	return b;
+}
+
+/* hand function
+	Queues the buffer being filled. Unless everything is wanted the
+	bytes after its last whole page move to a spare buffer, which
+	becomes the one being filled; with no spare buffer free nothing
+	is handed over and false is returned.
+*/
+bool CaptureWriter::hand(bool everything){
+	Buffer &buffer = buffers[filling];
+	size_t length = everything ? buffer.used : buffer.used / WRITER_ALIGN * WRITER_ALIGN;
+	if (length == 0){return false;}
+	size_t tail = buffer.used - length;
+
+	std::lock_guard<std::mutex> guard(lock);
+	int next = -1;
+	if (tail > 0){
+		if (spare.empty()){return false;}
+		next = spare.back();
+		spare.pop_back();
+		memcpy(buffers[next].data, buffer.data + length, tail);
+		buffers[next].used = tail;
+		filledSince = now();
+	}
+	buffer.used = length;
+	full.push_back(filling);
+	filling = next;
+
+	int depth = (int)full.size() + writing;
+	handed++;
+	depthTotal += depth;
+	if (depth > maxDepth){maxDepth = depth;}
+	queued.notify_one();
+	return true;
+}
+
+/* write function
+	Copies length bytes for the thread. Waits for a buffer when all
+	are queued, or drops the whole write with dropWhenFull.
+*/
+bool CaptureWriter::write(const void *data, size_t length){
+	if (fd < 0){return false;}
+	const unsigned char *from = (const unsigned char *)data;
+	if (dropWhenFull){
+		size_t room = (filling >= 0) ? size - buffers[filling].used : 0;
+		std::lock_guard<std::mutex> guard(lock);
+		if (room + spare.size() * size < length){
+			dropped++;
+			droppedBytes += length;
+			return false;
+		}
+	}
+
+	while (length > 0){
+		if (filling < 0){
+			filling = take();
+			buffers[filling].used = 0;
+			filledSince = now();
+		}
+		Buffer &buffer = buffers[filling];
+		size_t n = (length < size - buffer.used) ? length : size - buffer.used;
+		memcpy(buffer.data + buffer.used, from, n);
+		buffer.used += n;
+		from += n;
+		length -= n;
+		if (buffer.used == size){hand(true);}
+	}
+	if (filling >= 0 && maxAge > 0 && now() - filledSince >= maxAge){hand(false);}
+	return true;
+}
+
+/* flush function
+*/
+void CaptureWriter::flush(){
+	if (filling >= 0){hand(false);}
+}
+
+/* run function
+	The writer thread. Writes every queued buffer in one writev()
+	and returns them, until close() has nothing left for it.
+*/
+void CaptureWriter::run(){
+	if (traceRecorder().isEnabled()){traceRecorder().nameThread("writer");}
+	struct iovec io[IOV_MAX < 64 ? IOV_MAX : 64];
+	int batch[sizeof(io) / sizeof(io[0])];
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;){
+		queued.wait(guard, [this]{ return !full.empty() || stopping; });
+		if (full.empty()){break;}						// Stopping, all written
+		int n = 0;
+		while (!full.empty() && n < (int)(sizeof(batch) / sizeof(batch[0]))){
+			batch[n] = full.front();
+			io[n].iov_base = buffers[batch[n]].data;
+			io[n].iov_len = buffers[batch[n]].used;
+			full.pop_front();
+			n++;
+		}
+		writing = n;
+		guard.unlock();
+
+		TRACE_BEGIN("writev");
+		long long began = now();
+		struct iovec *next = io;
+		int left = n;
+		size_t written = 0;
+		bool failed = false;
+		while (left > 0){
+			ssize_t done = writev(fd, next, left);
+			if (done < 0){
+				if (errno == EINTR){continue;}
+				failed = true;
+				break;
+			}
+			if (done == 0){										// No progress, do not spin
+				failed = true;
+				break;
+			}
+			written += done;
+			while (left > 0 && (size_t)done >= next->iov_len){	// Short write, skip what went out
+				done -= next->iov_len;
+				next++;
+				left--;
+			}
+			if (left > 0){
+				next->iov_base = (unsigned char *)next->iov_base + done;
+				next->iov_len -= done;
+			}
+		}
+		long long took = now() - began;
+		TRACE_END("writev");
+
+		guard.lock();
+		for (int i = 0; i < n; i++){
+			buffers[batch[i]].used = 0;
+			spare.push_back(batch[i]);
+		}
+		writing = 0;
+		bytes += written;
+		writes++;
+		if (failed){errors++;}
+		writeTime += took;
+		if (took > longestWrite){longestWrite = took;}
+		freed.notify_one();
+	}
+}
+
+/* close function
+*/
+int CaptureWriter::close(){
+	if (fd < 0){return 0;}
+	if (filling >= 0){
+		if (buffers[filling].used > 0){hand(true);}
+		else{
+			std::lock_guard<std::mutex> guard(lock);
+			spare.push_back(filling);
+			filling = -1;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+		queued.notify_one();
+	}
+	worker.join();
+	if (fdatasync(fd) != 0){errors++;}
+	if (::close(fd) != 0){errors++;}
+	fd = -1;
+	return (errors == 0 && dropped == 0) ? 0 : -1;
+}
+
+double CaptureWriter::getThroughput(){
+	std::lock_guard<std::mutex> g(lock);
+	return writeTime > 0 ? bytes * 1e9 / writeTime : 0.0;
+}
+
+/* report function
+*/
+void CaptureWriter::report(FILE *out){
+	std::lock_guard<std::mutex> g(lock);
+	fprintf(out, "%.2f MB\t%lu writes\t%.1f MB/s\tlongest %.1f ms\tqueue %.2f mean, %d of %zu max\t%lu stalls %.1f ms",
+		bytes / 1048576.0, writes, writeTime > 0 ? bytes * 1e9 / writeTime / 1048576.0 : 0.0, longestWrite / 1e6,
+		handed ? (double)depthTotal / handed : 0.0, maxDepth, buffers.size(), stalls, stallTime / 1e6);
+	if (dropped > 0){fprintf(out, "\t%lu dropped (%llu bytes)", dropped, droppedBytes);}
+	if (errors > 0){fprintf(out, "\t%lu errors", errors);}
+	fprintf(out, "\n");
+}
+
+#endif /* CAPTUREWRITER_H_ */
@@ -0,0 +1,185 @@
+/* Coalescing Queue Header File
+
+	When several consumers want registers of the same device (the
+	data registers, STATUS_REG_A, the temperature) each one used to
+	cost its own transfer. Reads queued here are held until flush(),
+	which sorts them by device and register, merges reads that are
+	contiguous or within maxGap bytes of each other into a single
+	auto-increment burst, and hands every consumer its own slice of
+	the result.
+
+		STATUS_REG_A	0x27	1 byte
+		OUT_X_L_A		0x28	6 bytes		-> one 7 byte burst at 0xA7
+
+	A gap is never read if it holds a register whose read has a side
+	effect. On the LSM303 accelerometer (0x18, 0x19) INT1_SRC_A,
+	INT2_SRC_A and CLICK_SRC_A clear latched interrupts when read,
+	so they are marked from the start; setReadSensitive() marks
+	others. They are still read when a request asks for them.
+
+	Requests may be queued from any thread; flush() should be called
+	by the thread that owns the bus.
+*/
+
+#ifndef COALESCINGQUEUE_H_
+#define COALESCINGQUEUE_H_
+
+#include "I2CTransport.h"
+
+#include <algorithm>
+#include <bitset>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#define COALESCE_MAX_BURST	0x20	// Longest merged read
+#define COALESCE_AUTO_INC	0x80	// LSM303 accelerometer auto-increment bit
+#define COALESCE_REGISTERS	0x80	// Register addresses, without the auto-increment bit
+
+/* CoalescingQueue class definition
+	Holds pending reads for one bus and the counters that show
+	how many transfers merging saved.
+*/
+class CoalescingQueue {
+
+	public:
+		typedef std::function<void(int status, const char *data, int length)> Callback;
+
+	private:
+		struct Pending {
+			int device;							// 7-bit device address
+			int reg;							// First register, without auto-increment bit
+			int length;							// Bytes wanted
+			Callback done;						// Receives the slice, status 0 on success
+		};
+
+		I2CTransport &transport;				// Bus the reads go out on
+		int maxGap;								// Unrequested bytes allowed inside a burst
+		std::map<int, char> incrementBit;		// Per device, default COALESCE_AUTO_INC
+		std::map<int, std::bitset<COALESCE_REGISTERS> > sensitive;	// Per device, registers a read changes
+		std::mutex lock;						// Guards pending, the two maps and the counters
+		std::vector<Pending> pending;
+
+		unsigned long requested;				// Reads queued
+		unsigned long issued;					// Transfers actually made
+		unsigned long extraBytes;				// Gap bytes read only to allow a merge
+
+		void issue(std::vector<Pending> &group, int start, int end);
+		bool gapIsSafe(int device, int from, int to);
+
+	public:
+		CoalescingQueue(I2CTransport &bus, int maxGap = 2);
+
+		void read(int device, int reg, int length, Callback done);	// Queues a read
+		int  flush();								// Issues everything pending, returns transfers made
+		void setAutoIncrement(int device, char bit) { std::lock_guard<std::mutex> g(lock); incrementBit[device] = bit; }	// 0 for devices that always increment
+		void setReadSensitive(int device, int reg) { std::lock_guard<std::mutex> g(lock); sensitive[device].set(reg & 0x7F); }	// Never read it only to merge
+
+		unsigned long getRequested() { std::lock_guard<std::mutex> g(lock); return requested; }
+		unsigned long getIssued() { std::lock_guard<std::mutex> g(lock); return issued; }
+		unsigned long getMerged() { std::lock_guard<std::mutex> g(lock); return requested - issued; }
+		unsigned long getExtraBytes() { std::lock_guard<std::mutex> g(lock); return extraBytes; }
+};
+
+CoalescingQueue::CoalescingQueue(I2CTransport &bus, int gap)
+	: transport(bus), maxGap(gap), requested(0), issued(0), extraBytes(0) {
+	const int accelerometers[2] = { 0x18, 0x19 };
+	for (int a = 0; a < 2; a++){
+		sensitive[accelerometers[a]].set(0x31);		// INT1_SRC_A
+		sensitive[accelerometers[a]].set(0x35);		// INT2_SRC_A
+		sensitive[accelerometers[a]].set(0x39);		// CLICK_SRC_A
+	}
+}
+
+void CoalescingQueue::read(int device, int reg, int length, Callback done){
+	Pending p = { device, reg & 0x7F, std::min(length, COALESCE_MAX_BURST), done };
+	std::lock_guard<std::mutex> guard(lock);
+	pending.push_back(p);
+	requested++;
+}
+
+/* gapIsSafe function
+	True if registers from..to-1 of device may be read without
+	having been asked for.
+*/
+bool CoalescingQueue::gapIsSafe(int device, int from, int to){
+	std::lock_guard<std::mutex> guard(lock);
+	std::map<int, std::bitset<COALESCE_REGISTERS> >::const_iterator it = sensitive.find(device);
+	if (it == sensitive.end()){return true;}
+	for (int reg = from; reg < to; reg++){
+		if (it->second.test(reg & 0x7F)){return false;}
+	}
+	return true;
+}
+
+/* issue function
+	Reads registers start..end-1 of the group's device in one
+	transfer and fans the bytes out to every request in the group.
+*/
+void CoalescingQueue::issue(std::vector<Pending> &group, int start, int end){
+	int device = group[0].device;
+	char bit;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		bit = incrementBit.count(device) ? incrementBit[device] : (char)COALESCE_AUTO_INC;
+	}
+	char data[COALESCE_MAX_BURST];
+	int length = end - start;
+	char reg = (char)(length > 1 ? (start | bit) : start);
+
+	int status = (transport.readRegistersAt(device, reg, data, length) == length) ? 0 : 1;
+
+	int wanted = 0;
+	for (size_t i = 0; i < group.size(); i++){
+		group[i].done(status, data + (group[i].reg - start), group[i].length);
+		wanted += group[i].length;
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+	issued++;
+	if (length > wanted){extraBytes += length - wanted;}	// Overlaps can make wanted exceed length
+}
+
+/* flush function
+	Takes every pending read, groups them into bursts and issues
+	one transfer per burst.
+*/
+int CoalescingQueue::flush(){
+	TRACE_SCOPE("coalesce flush");
+	std::vector<Pending> work;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		work.swap(pending);
+	}
+	if (work.empty()){return 0;}
+
+	std::sort(work.begin(), work.end(), [](const Pending &a, const Pending &b){
+		if (a.device != b.device){return a.device < b.device;}
+		return a.reg < b.reg;
+	});
+
+	int transfers = 0;
+	std::vector<Pending> group;
+	int start = 0, end = 0;
+	for (size_t i = 0; i < work.size(); i++){
+		const Pending &p = work[i];
+		bool fits = !group.empty() && p.device == group[0].device
+			&& p.reg <= end + maxGap
+			&& std::max(end, p.reg + p.length) - start <= COALESCE_MAX_BURST
+			&& (p.reg <= end || gapIsSafe(p.device, end, p.reg));
+		if (!fits){
+			if (!group.empty()){issue(group, start, end); transfers++;}
+			group.clear();
+			start = p.reg;
+			end = p.reg;
+		}
+		group.push_back(p);
+		end = std::max(end, p.reg + p.length);
+	}
+	issue(group, start, end);
+	transfers++;
+	return transfers;
+}
+
+#endif /* COALESCINGQUEUE_H_ */
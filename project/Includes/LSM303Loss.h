@@ -0,0 +1,98 @@
+/* LSM303 Sample Loss Header File
+
+	Tells from the accelerometer's own status bits whether samples
+	were missed or read twice, instead of assuming every read is a
+	new sample (time_sig = read_count).
+
+	STATUS_REG_A (27h), read in the same burst as the data, before it:
+		ZYXDA	new X, Y and Z data since OUT_Z_H_A was last read;
+				clear means the read returns the old sample again
+		ZYXOR	a new sample overwrote one that was never read
+
+	FIFO_SRC_REG_A (2Fh), read before draining the FIFO:
+		OVRN	FIFO full, the oldest (stream) or newest (FIFO mode)
+				samples are being lost
+		EMPTY	nothing to read
+		FSS		number of unread samples
+
+	Plain C, shared by READ.c, PARSE.c and the C++ driver.
+*/
+
+#ifndef LSM303LOSS_H_
+#define LSM303LOSS_H_
+
+#include <stdio.h>
+
+#define STATUS_REG_A		0x27	// ZYXOR ZOR YOR XOR ZYXDA ZDA YDA XDA
+#define FIFO_SRC_REG_A		0x2F	// WTM OVRN_FIFO EMPTY FSS[4:0]
+
+#define STATUS_ZYXDA		0x08	// New sample ready
+#define STATUS_ZYXOR		0x80	// Sample overwritten before it was read
+#define FIFO_SRC_WTM		0x80	// Watermark reached
+#define FIFO_SRC_OVRN		0x40	// FIFO overrun
+#define FIFO_SRC_EMPTY		0x20	// FIFO empty
+#define FIFO_SRC_FSS		0x1F	// Unread samples
+
+/* sample_loss structure
+	Counters for one sensor stream.
+*/
+struct sample_loss{
+	unsigned long reads;			// Status checks made
+	unsigned long fresh;			// Reads that returned a new sample
+	unsigned long duplicates;		// Reads that returned the previous sample again
+	unsigned long overruns;			// Reads that found at least one sample lost before them
+};
+typedef struct sample_loss sample_loss;	// Define type for sample_loss
+
+/* LOSS_RESET function
+	Clears every counter.
+*/
+static inline void LOSS_RESET (sample_loss *loss){
+	loss->reads = 0;
+	loss->fresh = 0;
+	loss->duplicates = 0;
+	loss->overruns = 0;
+}
+
+/* LOSS_STATUS function
+	Accounts one STATUS_REG_A value read with a sample. Returns 1
+	if the sample that came with it is new, 0 if it is a duplicate.
+*/
+static inline int LOSS_STATUS (sample_loss *loss, unsigned char status){
+	loss->reads++;
+	if (status & STATUS_ZYXOR){loss->overruns++;}
+	if (!(status & STATUS_ZYXDA)){
+		loss->duplicates++;
+		return 0;
+	}
+	loss->fresh++;
+	return 1;
+}
+
+/* LOSS_FIFO function
+	Accounts one FIFO_SRC_REG_A value read before draining the FIFO.
+	Returns the number of samples that may be read. An empty FIFO
+	counts as a duplicate read since nothing new was there.
+*/
+static inline int LOSS_FIFO (sample_loss *loss, unsigned char source){
+	loss->reads++;
+	if (source & FIFO_SRC_OVRN){loss->overruns++;}
+	if (source & FIFO_SRC_EMPTY){
+		loss->duplicates++;
+		return 0;
+	}
+	int count = source & FIFO_SRC_FSS;
+	if (count == 0){count = 1;}		// Not empty, at least one
+	loss->fresh += count;
+	return count;
+}
+
+/* LOSS_PRINT function
+	One line summary of a stream's counters.
+*/
+static inline void LOSS_PRINT (const sample_loss *loss, FILE *out){
+	fprintf(out, "%lu reads\t%lu new\t%lu duplicates\t%lu overruns\n",
+		loss->reads, loss->fresh, loss->duplicates, loss->overruns);
+}
+
+#endif /* LSM303LOSS_H_ */
@@ -0,0 +1,410 @@
+/* LSM303 Register Profile Header File
+
+	A profile is the complete accelerometer configuration: the six
+	control registers, the FIFO control register and both interrupt
+	generators. PROFILE_APPLY writes all of it in one I2C_RDWR
+	transaction and PROFILE_VERIFY reads it all back in a second
+	one, instead of one i2cset process (SETUP.c) or one open/write/
+	close (writeI2CDeviceByte) per register.
+
+	Profiles can also be described declaratively (ODR, range, mode,
+	axes, FIFO, filter) in a profile_spec, filled from a file or
+	from command line options, validated once by PROFILE_VALIDATE
+	and turned into register values by PROFILE_BUILD.
+
+	Plain C so that both SETUP.c and the C++ driver can use it.
+
+	Register addresses from page 23 of the LSM303 datasheet,
+	section 6 Register mapping table 17. Register address map.
+*/
+
+#ifndef LSM303PROFILE_H_
+#define LSM303PROFILE_H_
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CTRL_REG1_A			0x20	// ODR[3:0] LPen Zen Yen Xen
+#define CTRL_REG2_A			0x21	// HPM[1:0] HPCF[2:1] FDS HPCLICK HPIS2 HPIS1
+#define CTRL_REG4_A			0x23	// BDU BLE FS[1:0] HR 0 0 SIM
+#define CTRL_REG5_A			0x24	// BOOT FIFO_EN -- -- LIR_INT1 D4D_INT1 LIR_INT2 D4D_INT2
+#define CTRL_REG6_A			0x25	// Last of the six control registers
+#define FIFO_CTRL_REG_A		0x2E	// FM[1:0] TR FTH[4:0]
+#define INT1_CFG_A			0x30	// Interrupt 1 configuration
+#define INT1_THS_A			0x32	// Interrupt 1 threshold
+#define INT2_CFG_A			0x34	// Interrupt 2 configuration
+#define INT2_THS_A			0x36	// Interrupt 2 threshold
+
+#define PROFILE_AUTO_INC	0x80	// Sub-address MSB, enables auto-increment
+#define PROFILE_CTRL_COUNT	6		// CTRL_REG1_A..CTRL_REG6_A
+
+/* profile structure
+	Raw register values, in the order they appear on the device.
+*/
+struct profile{
+	unsigned char ctrl[PROFILE_CTRL_COUNT];	// CTRL_REG1_A..CTRL_REG6_A	(0x20-0x25)
+	unsigned char fifo_ctrl;				// FIFO_CTRL_REG_A			(0x2E)
+	unsigned char int1_cfg;					// INT1_CFG_A				(0x30)
+	unsigned char int1_ths;					// INT1_THS_A				(0x32)
+	unsigned char int1_duration;			// INT1_DURATION_A			(0x33)
+	unsigned char int2_cfg;					// INT2_CFG_A				(0x34)
+	unsigned char int2_ths;					// INT2_THS_A				(0x36)
+	unsigned char int2_duration;			// INT2_DURATION_A			(0x37)
+};
+typedef struct profile profile;	// Define type for profile
+
+/* PROFILE_DEFAULT function
+	Fills a profile with the power-on values: power down, all axes
+	enabled, FIFO bypassed and interrupts off (datasheet table 19).
+*/
+static inline void PROFILE_DEFAULT (profile *p){
+	memset(p, 0, sizeof(profile));
+	p->ctrl[0] = 0x07;	// CTRL_REG1_A default 0000 0111
+}
+
+/* profile_transfer type
+	Carries out one combined transaction, returns < 0 on failure.
+	PROFILE_APPLY and PROFILE_VERIFY use ioctl(I2C_RDWR) on a file,
+	the _WITH variants let the C++ transports supply their own.
+*/
+typedef int (*profile_transfer)(void *context, struct i2c_msg *messages, int count);
+
+/* PROFILE_IOCTL function
+	The profile_transfer for a plain /dev/i2c-N file handle.
+*/
+static inline int PROFILE_IOCTL (void *context, struct i2c_msg *messages, int count){
+	struct i2c_rdwr_ioctl_data transaction = { messages, (__u32)count };
+	return ioctl(*(int *)context, I2C_RDWR, &transaction);
+}
+
+/* PROFILE_APPLY_WITH function
+	Writes the whole profile in a single transaction of six write
+	messages. The control registers go out as one auto-increment
+	burst, the interrupt threshold/duration pairs as two more.
+	Returns 0 on success, 1 if the transaction was refused.
+*/
+static inline int PROFILE_APPLY_WITH (profile_transfer transfer, void *context, int dev_addr, const profile *p){
+	unsigned char ctrl[1 + PROFILE_CTRL_COUNT];
+	unsigned char fifo[2]	= { FIFO_CTRL_REG_A, p->fifo_ctrl };
+	unsigned char int1[2]	= { INT1_CFG_A, p->int1_cfg };
+	unsigned char ths1[3]	= { INT1_THS_A | PROFILE_AUTO_INC, p->int1_ths, p->int1_duration };
+	unsigned char int2[2]	= { INT2_CFG_A, p->int2_cfg };
+	unsigned char ths2[3]	= { INT2_THS_A | PROFILE_AUTO_INC, p->int2_ths, p->int2_duration };
+
+	ctrl[0] = CTRL_REG1_A | PROFILE_AUTO_INC;					// Burst start
+	memcpy(ctrl + 1, p->ctrl, PROFILE_CTRL_COUNT);				// CTRL_REG1_A..CTRL_REG6_A
+
+	struct i2c_msg messages[6] = {
+		{ (__u16)dev_addr, 0, sizeof(ctrl), ctrl },
+		{ (__u16)dev_addr, 0, sizeof(fifo), fifo },
+		{ (__u16)dev_addr, 0, sizeof(int1), int1 },
+		{ (__u16)dev_addr, 0, sizeof(ths1), ths1 },
+		{ (__u16)dev_addr, 0, sizeof(int2), int2 },
+		{ (__u16)dev_addr, 0, sizeof(ths2), ths2 }
+	};
+
+	if (transfer(context, messages, 6) < 0){
+		return 1;
+	}
+	return 0;
+}
+
+/* PROFILE_APPLY function
+	PROFILE_APPLY_WITH over I2C_RDWR on an open bus file.
+*/
+static inline int PROFILE_APPLY (int file, int dev_addr, const profile *p){
+	return PROFILE_APPLY_WITH(PROFILE_IOCTL, &file, dev_addr, p);
+}
+
+/* PROFILE_VERIFY_WITH function
+	Reads every profile register back in a single transaction of
+	six write/read pairs, laid out like the writes of
+	PROFILE_APPLY_WITH, and compares them with the profile.
+	INT1_SRC_A (0x31) and INT2_SRC_A (0x35) sit between CFG and
+	THS but are cleared by a read, so each CFG is read on its own
+	and THS/DURATION as a burst after it. Returns 0 on match, 1 if
+	the transaction was refused, 2 on a mismatch.
+*/
+static inline int PROFILE_VERIFY_WITH (profile_transfer transfer, void *context, int dev_addr, const profile *p){
+	unsigned char ctrl_addr	= CTRL_REG1_A | PROFILE_AUTO_INC;
+	unsigned char fifo_addr	= FIFO_CTRL_REG_A;
+	unsigned char int1_addr	= INT1_CFG_A;
+	unsigned char ths1_addr	= INT1_THS_A | PROFILE_AUTO_INC;
+	unsigned char int2_addr	= INT2_CFG_A;
+	unsigned char ths2_addr	= INT2_THS_A | PROFILE_AUTO_INC;
+	unsigned char ctrl[PROFILE_CTRL_COUNT], fifo[1], int1[1], ths1[2], int2[1], ths2[2];
+
+	struct i2c_msg messages[12] = {
+		{ (__u16)dev_addr, 0, 1, &ctrl_addr },
+		{ (__u16)dev_addr, I2C_M_RD, sizeof(ctrl), ctrl },
+		{ (__u16)dev_addr, 0, 1, &fifo_addr },
+		{ (__u16)dev_addr, I2C_M_RD, sizeof(fifo), fifo },
+		{ (__u16)dev_addr, 0, 1, &int1_addr },
+		{ (__u16)dev_addr, I2C_M_RD, sizeof(int1), int1 },
+		{ (__u16)dev_addr, 0, 1, &ths1_addr },
+		{ (__u16)dev_addr, I2C_M_RD, sizeof(ths1), ths1 },	// THS, DURATION
+		{ (__u16)dev_addr, 0, 1, &int2_addr },
+		{ (__u16)dev_addr, I2C_M_RD, sizeof(int2), int2 },
+		{ (__u16)dev_addr, 0, 1, &ths2_addr },
+		{ (__u16)dev_addr, I2C_M_RD, sizeof(ths2), ths2 }	// ...
+	};
+
+	if (transfer(context, messages, 12) < 0){
+		return 1;
+	}
+
+	if (memcmp(ctrl, p->ctrl, PROFILE_CTRL_COUNT) != 0){return 2;}
+	if (fifo[0] != p->fifo_ctrl){return 2;}
+	if (int1[0] != p->int1_cfg || ths1[0] != p->int1_ths || ths1[1] != p->int1_duration){return 2;}
+	if (int2[0] != p->int2_cfg || ths2[0] != p->int2_ths || ths2[1] != p->int2_duration){return 2;}
+	return 0;
+}
+
+/* PROFILE_VERIFY function
+	PROFILE_VERIFY_WITH over I2C_RDWR on an open bus file.
+*/
+static inline int PROFILE_VERIFY (int file, int dev_addr, const profile *p){
+	return PROFILE_VERIFY_WITH(PROFILE_IOCTL, &file, dev_addr, p);
+}
+
+/* Declarative settings
+	Values accepted by PROFILE_SET, see the datasheet sections
+	7.1.1 CTRL_REG1_A, 7.1.2 CTRL_REG2_A, 7.1.4 CTRL_REG4_A and
+	7.1.7 FIFO_CTRL_REG_A.
+*/
+enum PROFILE_MODE {			// LPen	HR
+	PROFILE_MODE_NORMAL		= 0,	// 0	0
+	PROFILE_MODE_LOW_POWER	= 1,	// 1	0
+	PROFILE_MODE_HIGH_RES	= 2		// 0	1
+};
+
+enum PROFILE_FIFO {			// FM1	FM0
+	PROFILE_FIFO_BYPASS		= 0,	// 0	0
+	PROFILE_FIFO_FIFO		= 1,	// 0	1
+	PROFILE_FIFO_STREAM		= 2,	// 1	0
+	PROFILE_FIFO_TRIGGER	= 3		// 1	1
+};
+
+enum PROFILE_FILTER {		// HPM1	HPM0	(-1 disables the filter)
+	PROFILE_FILTER_OFF		= -1,
+	PROFILE_FILTER_NORMAL	= 0,	// 0	0	Normal mode, reset by reading REFERENCE
+	PROFILE_FILTER_REFERENCE = 1,	// 0	1	Reference signal for filtering
+	PROFILE_FILTER_AUTORESET = 3	// 1	1	Autoreset on interrupt event
+};
+
+#define PROFILE_AXIS_X	0x01	// Xen
+#define PROFILE_AXIS_Y	0x02	// Yen
+#define PROFILE_AXIS_Z	0x04	// Zen
+
+/* profile_spec structure
+	What the user asks for, before it becomes register values.
+*/
+struct profile_spec{
+	int odr;				// Output data rate in Hz, 0 is power down
+	int range;				// Full scale in g: 2, 4, 8 or 16
+	int mode;				// PROFILE_MODE
+	int axes;				// PROFILE_AXIS mask
+	int fifo;				// PROFILE_FIFO
+	int threshold;			// FIFO watermark, 0-31
+	int filter;				// PROFILE_FILTER
+	int cutoff;				// High-pass cut-off selection HPCF, 0-3
+};
+typedef struct profile_spec profile_spec;	// Define type for profile_spec
+
+/* PROFILE_SPEC_DEFAULT function
+	100 Hz, 2g, normal mode, all axes, FIFO bypassed, no filter.
+*/
+static inline void PROFILE_SPEC_DEFAULT (profile_spec *spec){
+	spec->odr = 100;
+	spec->range = 2;
+	spec->mode = PROFILE_MODE_NORMAL;
+	spec->axes = PROFILE_AXIS_X | PROFILE_AXIS_Y | PROFILE_AXIS_Z;
+	spec->fifo = PROFILE_FIFO_BYPASS;
+	spec->threshold = 0;
+	spec->filter = PROFILE_FILTER_OFF;
+	spec->cutoff = 0;
+}
+
+/* PROFILE_ODR_CODE function
+	Maps a rate in Hz to ODR[3:0] (table 20), or -1 if the
+	device has no such rate. 1620 and 5376 Hz are the low-power
+	only rates, 1344 Hz is the same code in normal mode.
+*/
+static inline int PROFILE_ODR_CODE (int odr){
+	switch(odr){
+		case 0:		return 0x0;
+		case 1:		return 0x1;
+		case 10:	return 0x2;
+		case 25:	return 0x3;
+		case 50:	return 0x4;
+		case 100:	return 0x5;
+		case 200:	return 0x6;
+		case 400:	return 0x7;
+		case 1620:	return 0x8;
+		case 1344:
+		case 5376:	return 0x9;
+		default:	return -1;
+	}
+}
+
+/* PROFILE_ODR_HZ function
+	The other way round: the rate in Hz selected by a CTRL_REG1_A
+	value, 0 for power down or a reserved code. Code 9 depends on
+	LPen: 1344 Hz normal, 5376 Hz low-power.
+*/
+static inline double PROFILE_ODR_HZ (unsigned char ctrl_reg1){
+	static const double rates[] = { 0, 1, 10, 25, 50, 100, 200, 400, 1620, 1344 };
+	int code = ctrl_reg1 >> 4;
+	if (code > 9){return 0;}
+	if (code == 9 && (ctrl_reg1 & 0x08)){return 5376;}
+	return rates[code];
+}
+
+/* PROFILE_SET function
+	Sets one named setting from its text value. Returns 0 on
+	success, 1 for an unknown key and 2 for a malformed value.
+	Cross-setting rules are left to PROFILE_VALIDATE.
+*/
+static inline int PROFILE_SET (profile_spec *spec, const char *key, const char *value){
+	char *end;
+	long number = strtol(value, &end, 10);
+	int numeric = (*value != '\0' && *end == '\0');
+
+	if (strcmp(key, "odr") == 0){
+		if (!numeric){return 2;}
+		spec->odr = (int)number;
+	}
+	else if (strcmp(key, "range") == 0){
+		if (!numeric){return 2;}
+		spec->range = (int)number;
+	}
+	else if (strcmp(key, "mode") == 0){
+		if (strcmp(value, "normal") == 0){spec->mode = PROFILE_MODE_NORMAL;}
+		else if (strcmp(value, "lowpower") == 0){spec->mode = PROFILE_MODE_LOW_POWER;}
+		else if (strcmp(value, "highres") == 0){spec->mode = PROFILE_MODE_HIGH_RES;}
+		else{return 2;}
+	}
+	else if (strcmp(key, "axes") == 0){
+		int axes = 0;
+		const char *c;
+		for (c = value; *c != '\0'; c++){
+			if (*c == 'x'){axes |= PROFILE_AXIS_X;}
+			else if (*c == 'y'){axes |= PROFILE_AXIS_Y;}
+			else if (*c == 'z'){axes |= PROFILE_AXIS_Z;}
+			else if (*c == '-' && c == value && c[1] == '\0'){/*No axes*/}
+			else{return 2;}
+		}
+		spec->axes = axes;
+	}
+	else if (strcmp(key, "fifo") == 0){
+		if (strcmp(value, "bypass") == 0){spec->fifo = PROFILE_FIFO_BYPASS;}
+		else if (strcmp(value, "fifo") == 0){spec->fifo = PROFILE_FIFO_FIFO;}
+		else if (strcmp(value, "stream") == 0){spec->fifo = PROFILE_FIFO_STREAM;}
+		else if (strcmp(value, "trigger") == 0){spec->fifo = PROFILE_FIFO_TRIGGER;}
+		else{return 2;}
+	}
+	else if (strcmp(key, "threshold") == 0){
+		if (!numeric){return 2;}
+		spec->threshold = (int)number;
+	}
+	else if (strcmp(key, "filter") == 0){
+		if (strcmp(value, "off") == 0){spec->filter = PROFILE_FILTER_OFF;}
+		else if (strcmp(value, "normal") == 0){spec->filter = PROFILE_FILTER_NORMAL;}
+		else if (strcmp(value, "reference") == 0){spec->filter = PROFILE_FILTER_REFERENCE;}
+		else if (strcmp(value, "autoreset") == 0){spec->filter = PROFILE_FILTER_AUTORESET;}
+		else{return 2;}
+	}
+	else if (strcmp(key, "cutoff") == 0){
+		if (!numeric){return 2;}
+		spec->cutoff = (int)number;
+	}
+	else{
+		return 1;
+	}
+	return 0;
+}
+
+/* PROFILE_LOAD function
+	Reads "key = value" (or "key value") lines into spec. Blank
+	lines and anything after '#' are ignored. Returns 0 on
+	success, -1 if the file cannot be opened, otherwise the number
+	of the first offending line.
+*/
+static inline int PROFILE_LOAD (const char *filename, profile_spec *spec){
+	FILE *fpIN = fopen(filename, "r");
+	if (fpIN == NULL){return -1;}
+
+	char line[128];
+	int line_number = 0;
+	while (fgets(line, sizeof(line), fpIN) != NULL){
+		line_number++;
+
+		char *c = strchr(line, '#');		// Strip comments
+		if (c != NULL){*c = '\0';}
+		for (c = line; *c != '\0'; c++){	// '=' is just a separator
+			if (*c == '='){*c = ' ';}
+		}
+
+		char key[32], value[32], extra[2];
+		int n = sscanf(line, "%31s %31s %1s", key, value, extra);
+		if (n == EOF || n == 0){continue;}				// Blank line
+		if (n != 2 || PROFILE_SET(spec, key, value) != 0){
+			fclose(fpIN);
+			return line_number;
+		}
+	}
+	fclose(fpIN);
+	return 0;
+}
+
+/* PROFILE_VALIDATE function
+	Checks every setting and the rules between them. Returns NULL
+	if the spec can be built, otherwise a description of the
+	first problem.
+*/
+static inline const char *PROFILE_VALIDATE (const profile_spec *spec){
+	if (PROFILE_ODR_CODE(spec->odr) < 0){return "odr must be 0, 1, 10, 25, 50, 100, 200, 400, 1344, 1620 or 5376";}
+	if (spec->range != 2 && spec->range != 4 && spec->range != 8 && spec->range != 16){return "range must be 2, 4, 8 or 16";}
+	if ((spec->odr == 1620 || spec->odr == 5376) && spec->mode != PROFILE_MODE_LOW_POWER){return "odr 1620 and 5376 require mode lowpower";}
+	if (spec->odr == 1344 && spec->mode == PROFILE_MODE_LOW_POWER){return "odr 1344 is not available in mode lowpower, use 5376";}
+	if (spec->odr != 0 && spec->axes == 0){return "at least one axis must be enabled";}
+	if (spec->threshold < 0 || spec->threshold > 31){return "threshold must be 0-31";}
+	if (spec->threshold != 0 && spec->fifo == PROFILE_FIFO_BYPASS){return "threshold needs a fifo mode other than bypass";}
+	if (spec->cutoff < 0 || spec->cutoff > 3){return "cutoff must be 0-3";}
+	return NULL;
+}
+
+/* PROFILE_BUILD function
+	Turns a validated spec into register values. Block data
+	update is always set so that the two bytes of an axis are
+	never from different samples.
+*/
+static inline void PROFILE_BUILD (const profile_spec *spec, profile *p){
+	PROFILE_DEFAULT(p);
+
+	// CTRL_REG1_A: ODR[3:0] LPen Zen Yen Xen
+	p->ctrl[0] = (PROFILE_ODR_CODE(spec->odr) << 4) | (spec->axes & 0x07);
+	if (spec->mode == PROFILE_MODE_LOW_POWER){p->ctrl[0] |= 0x08;}
+
+	// CTRL_REG2_A: HPM[1:0] HPCF[2:1] FDS
+	if (spec->filter != PROFILE_FILTER_OFF){
+		p->ctrl[CTRL_REG2_A - CTRL_REG1_A] = (spec->filter << 6) | (spec->cutoff << 4) | 0x08;
+	}
+
+	// CTRL_REG4_A: BDU FS[1:0] HR
+	int fs = (spec->range == 16) ? 3 : (spec->range == 8) ? 2 : (spec->range == 4) ? 1 : 0;
+	p->ctrl[CTRL_REG4_A - CTRL_REG1_A] = 0x80 | (fs << 4);
+	if (spec->mode == PROFILE_MODE_HIGH_RES){p->ctrl[CTRL_REG4_A - CTRL_REG1_A] |= 0x08;}
+
+	// CTRL_REG5_A and FIFO_CTRL_REG_A: FIFO_EN, FM[1:0] FTH[4:0]
+	if (spec->fifo != PROFILE_FIFO_BYPASS){
+		p->ctrl[CTRL_REG5_A - CTRL_REG1_A] = 0x40;
+		p->fifo_ctrl = (spec->fifo << 6) | (spec->threshold & 0x1F);
+	}
+}
+
+#endif /* LSM303PROFILE_H_ */
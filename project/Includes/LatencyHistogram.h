@@ -0,0 +1,218 @@
+/* Latency Histogram Header File
+
+	Where does the time go between the sensor latching a sample and
+	the application using it? Each pipeline stage records the age
+	of the sample (now minus its release time) when the stage is
+	done with it:
+
+		bus			BusScheduler, transfer complete
+		decode		AcquisitionSession::push(), status byte checked
+					and the sample numbered by its clock
+		store		AcquisitionSession::push(), sample in the ring
+		process		AcquisitionSession::pop(), consumer has it
+		write		the consumer, after writing the sample out
+
+	Ages go into HDR-style histograms: 128 linear sub-buckets per
+	power of two, so every value is kept to within 1% from 1 ns up
+	to about 18 minutes in 2304 counters. Recording is a couple of
+	relaxed atomic increments, no lock and no allocation, and may
+	happen on any thread.
+
+	Read at runtime with pipelineLatency().report(), or send the
+	process the signal given to watchSignal() (SIGUSR1 by default);
+	the next pollSignal() from the application loop prints the
+	report, outside the signal handler.
+
+	Needs -std=c++11.
+*/
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define LATENCY_SUB_BITS	7									// 128 sub-buckets, < 1% error
+#define LATENCY_SUB_COUNT	(1 << LATENCY_SUB_BITS)
+#define LATENCY_HALF_COUNT	(LATENCY_SUB_COUNT / 2)
+#define LATENCY_MAX_BITS	40									// 2^40 ns, larger ages are clamped
+#define LATENCY_TOP			(LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1)		// Highest magnitude
+#define LATENCY_BUCKETS		((LATENCY_TOP + 2) * LATENCY_HALF_COUNT)
+
+/* LATENCY_STAGE enumeration
+	Pipeline stages, in the order a sample passes them.
+*/
+enum LATENCY_STAGE {
+	LATENCY_BUS		= 0,
+	LATENCY_DECODE	= 1,
+	LATENCY_STORE	= 2,
+	LATENCY_PROCESS	= 3,
+	LATENCY_WRITE	= 4,
+	LATENCY_STAGES	= 5
+};
+
+static const char *const latencyStageNames[LATENCY_STAGES] = { "bus", "decode", "store", "process", "write" };
+
+/* latencyNow function
+	CLOCK_MONOTONIC in nanoseconds, the clock sample release times
+	are taken on.
+*/
+static inline long long latencyNow(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* LatencyHistogram class definition
+	One stage's distribution. Percentiles are the highest value
+	equivalent to the bucket they fall in, as HdrHistogram does.
+*/
+class LatencyHistogram {
+
+	private:
+		std::atomic<unsigned long long> counts[LATENCY_BUCKETS];
+		std::atomic<unsigned long long> total;
+		std::atomic<long long> maximum;
+		std::atomic<long long> sum;			// For the mean
+
+		static int indexOf(long long value);
+		static long long highestOf(int index);	// Largest value stored at index
+
+	public:
+		LatencyHistogram() { reset(); }
+
+		void record(long long nanoseconds);
+		void reset();
+
+		unsigned long long getCount() { return total.load(std::memory_order_relaxed); }
+		long long getMax() { return maximum.load(std::memory_order_relaxed); }
+		double getMean() { unsigned long long n = getCount(); return n ? (double)sum.load(std::memory_order_relaxed) / n : 0; }
+		long long percentile(double percent);	// e.g. 99.9
+};
+
+int LatencyHistogram::indexOf(long long value){
+	if (value < LATENCY_SUB_COUNT){return value < 0 ? 0 : (int)value;}
+	int magnitude = 63 - __builtin_clzll((unsigned long long)value) - (LATENCY_SUB_BITS - 1);	// >= 1
+	if (magnitude > LATENCY_TOP){return LATENCY_BUCKETS - 1;}
+	return magnitude * LATENCY_HALF_COUNT + (int)(value >> magnitude);
+}
+
+long long LatencyHistogram::highestOf(int index){
+	if (index < LATENCY_SUB_COUNT){return index;}
+	int magnitude = index / LATENCY_HALF_COUNT - 1;
+	long long sub = index - magnitude * LATENCY_HALF_COUNT;
+	return ((sub + 1) << magnitude) - 1;
+}
+
+void LatencyHistogram::record(long long nanoseconds){
+	if (nanoseconds < 0){nanoseconds = 0;}	// Release times in the future, e.g. a replay
+	counts[indexOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+	long long seen = maximum.load(std::memory_order_relaxed);
+	while (nanoseconds > seen && !maximum.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)){}
+}
+
+void LatencyHistogram::reset(){
+	for (int i = 0; i < LATENCY_BUCKETS; i++){counts[i].store(0, std::memory_order_relaxed);}
+	total = 0;
+	maximum = 0;
+	sum = 0;
+}
+
+/* percentile function
+	Walks the buckets until the requested share of the samples is
+	covered. Concurrent records may be half counted, which moves the
+	answer by at most one sample.
+*/
+long long LatencyHistogram::percentile(double percent){
+	unsigned long long n = getCount();
+	if (n == 0){return 0;}
+	unsigned long long wanted = (unsigned long long)(percent / 100.0 * n + 0.5);
+	if (wanted < 1){wanted = 1;}
+	unsigned long long seen = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++){
+		seen += counts[i].load(std::memory_order_relaxed);
+		if (seen >= wanted){
+			long long value = highestOf(i);
+			long long top = getMax();
+			return value < top ? value : top;
+		}
+	}
+	return getMax();
+}
+
+/* StageLatency class definition
+	One histogram per stage, and the runtime report.
+*/
+class StageLatency {
+
+	private:
+		LatencyHistogram stages[LATENCY_STAGES];
+		std::atomic<bool> enabled;
+
+		static volatile sig_atomic_t requested;	// Set by the signal handler
+		static void onSignal(int) { requested = 1; }
+
+	public:
+		StageLatency() : enabled(true) {}
+
+		// Age of a sample released at releasedAt, now
+		void mark(LATENCY_STAGE stage, long long releasedAt) {
+			if (enabled.load(std::memory_order_relaxed)){stages[stage].record(latencyNow() - releasedAt);}
+		}
+		void record(LATENCY_STAGE stage, long long nanoseconds) {
+			if (enabled.load(std::memory_order_relaxed)){stages[stage].record(nanoseconds);}
+		}
+
+		void setEnabled(bool on) { enabled = on; }
+		bool isEnabled() { return enabled; }
+		LatencyHistogram &getStage(LATENCY_STAGE stage) { return stages[stage]; }
+		void reset() { for (int i = 0; i < LATENCY_STAGES; i++){stages[i].reset();} }
+
+		void report(FILE *out);					// p50, p99, p99.9 and max per stage, in microseconds
+		void watchSignal(int signal = SIGUSR1);	// Report on the next pollSignal() after signal
+		bool pollSignal(FILE *out);				// Returns true if it reported
+};
+
+volatile sig_atomic_t StageLatency::requested = 0;
+
+void StageLatency::report(FILE *out){
+	fprintf(out, "%-8s %10s %10s %10s %10s %10s %10s\n", "stage", "samples", "mean us", "p50 us", "p99 us", "p99.9 us", "max us");
+	for (int i = 0; i < LATENCY_STAGES; i++){
+		LatencyHistogram &h = stages[i];
+		if (h.getCount() == 0){continue;}		// Stage not instrumented in this program
+		fprintf(out, "%-8s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", latencyStageNames[i], h.getCount(),
+			h.getMean() / 1e3, h.percentile(50) / 1e3, h.percentile(99) / 1e3, h.percentile(99.9) / 1e3, h.getMax() / 1e3);
+	}
+	fflush(out);
+}
+
+void StageLatency::watchSignal(int signal){
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = onSignal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(signal, &action, NULL);
+}
+
+bool StageLatency::pollSignal(FILE *out){
+	if (!requested){return false;}
+	requested = 0;
+	report(out);
+	return true;
+}
+
+/* pipelineLatency function
+	The process-wide instance every stage records into.
+*/
+inline StageLatency &pipelineLatency(){
+	static StageLatency latency;
+	return latency;
+}
+
+#endif /* LATENCYHISTOGRAM_H_ */
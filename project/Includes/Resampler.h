@@ -0,0 +1,302 @@
+/* Resampler Header File
+
+	Puts a stream of timestamped samples onto an exact uniform time
+	grid, for integration and FFTs that assume one. Output times are
+	whole multiples of the output period on the input's clock (for
+	sessions, CLOCK_MONOTONIC_RAW through sampleTime), so streams of
+	different sensors resampled to the same rate line up.
+
+		linear	straight line between the two inputs around each
+				output time; cheap, no look-ahead, some loss near
+				the input Nyquist
+		sinc	Blackman windowed sinc over RESAMPLE_TAPS input
+				samples, cut off below the lower of the two Nyquist
+				rates, so it also works as the anti-alias filter
+				when the output is slower
+
+	The sinc kernel is a polyphase table, RESAMPLE_PHASES values per
+	input period, read with linear interpolation between phases.
+	Weights are taken at the real distance of every input from the
+	output time and normalised to sum to one, so irregular inputs
+	and short gaps keep unity gain. The sinc still expects inputs
+	close to a grid of their own, e.g. the fitted sample times of
+	SampleClock.h; at a jitter of a few percent of the input period
+	it is no better than linear, which is the one to use on raw
+	read times.
+
+	Streaming: push() inputs in time order, pull() whatever outputs
+	the inputs so far settle; anything pending waits for the next
+	batch. Inputs are kept axis by axis in contiguous arrays so the
+	filter's inner loops auto-vectorise (-O3, or -O2 on GCC 12+).
+
+	Needs -std=c++11.
+*/
+
+#ifndef RESAMPLER_H_
+#define RESAMPLER_H_
+
+#include "AcquisitionSession.h"
+
+#include <math.h>
+#include <vector>
+
+#define RESAMPLE_TAPS		16		// Sinc kernel width in input samples, at full bandwidth
+#define RESAMPLE_PHASES		256		// Kernel table entries per input period
+#define RESAMPLE_CUTOFF		0.9		// Passband edge as a share of the lower Nyquist rate
+#define RESAMPLE_KEEP		4096	// Consumed inputs allowed to pile up before compaction
+
+/* RESAMPLE_METHOD enumeration
+	Interpolation used between the inputs.
+*/
+enum RESAMPLE_METHOD {
+	RESAMPLE_LINEAR	= 0,
+	RESAMPLE_SINC	= 1
+};
+
+/* ResampledSample structure
+	One output point, acceleration in raw counts.
+*/
+struct ResampledSample {
+	long long timestamp;					// Grid time, nanoseconds
+	float x, y, z;
+};
+
+/* Resampler class definition
+*/
+class Resampler {
+
+	private:
+		RESAMPLE_METHOD method;
+		double outputPeriod;					// Nanoseconds
+		double inputPeriod;						// Nanoseconds, set or estimated
+		bool   inputGiven;						// setInputRate() was called
+
+		std::vector<long long> times;			// Inputs not yet consumed, oldest first
+		std::vector<float> xs, ys, zs;			// ... per axis
+		size_t first;							// Oldest input still needed
+		long long gridStart;					// Output times are gridStart + n * outputPeriod
+		long long emitted;						// Outputs produced, the next n
+
+		std::vector<float> kernel;				// h(u) at u = i / RESAMPLE_PHASES, u >= 0
+		std::vector<float> weights;				// Scratch, one per input in the window
+		double cutoff;							// Of the kernel, in cycles per input sample
+		double reach;							// Kernel half-width, input samples
+
+		void buildKernel();
+		long long gridTime(long long n) { return gridStart + (long long)(n * outputPeriod + 0.5); }
+		float kernelAt(double u);				// Table lookup, u in input samples
+		void  interpolate(long long t, ResampledSample &out);	// Linear, between first and first + 1
+		bool  produce(ResampledSample &out);	// Next output if its inputs are all in
+		void  compact();
+
+	public:
+		Resampler(double outputRate, RESAMPLE_METHOD method = RESAMPLE_LINEAR);
+
+		void setInputRate(double rate);			// Nominal input rate, else estimated from the inputs
+		void push(long long timestamp, float x, float y, float z);
+		void push(const RawSample *samples, size_t count);	// Counts decoded from the raw bytes, at sampleTime
+		size_t pull(ResampledSample *out, size_t max);		// Returns outputs written
+		void reset();
+
+		double getOutputRate() { return 1e9 / outputPeriod; }
+		double getInputRate() { return inputPeriod > 0 ? 1e9 / inputPeriod : 0; }
+		long long getLatency();					// Nanoseconds an output waits for later inputs
+};
+
+Resampler::Resampler(double outputRate, RESAMPLE_METHOD method)
+	: method(method), outputPeriod(1e9 / outputRate), inputPeriod(0), inputGiven(false) {
+	reset();
+}
+
+void Resampler::reset(){
+	times.clear();
+	xs.clear();
+	ys.clear();
+	zs.clear();
+	first = 0;
+	gridStart = -1;
+	emitted = 0;
+	if (!inputGiven){inputPeriod = 0;}
+	kernel.clear();
+	cutoff = 0;								// Set by buildKernel()
+	reach = 0;
+}
+
+void Resampler::setInputRate(double rate){
+	inputPeriod = 1e9 / rate;
+	inputGiven = true;
+	kernel.clear();							// Rebuilt for the new ratio
+}
+
+/* buildKernel function
+	Tabulates the windowed sinc for the current rate ratio. When the
+	output is slower the cutoff drops with it and the kernel widens
+	by the same factor, so it keeps RESAMPLE_TAPS lobes' worth of
+	selectivity at the new Nyquist.
+*/
+void Resampler::buildKernel(){
+	double ratio = inputPeriod / outputPeriod;					// Output samples per input sample
+	cutoff = 0.5 * RESAMPLE_CUTOFF * (ratio < 1 ? ratio : 1);	// Cycles per input sample
+	reach = RESAMPLE_TAPS / 2 / (ratio < 1 ? ratio : 1);
+	int size = (int)(reach * RESAMPLE_PHASES) + 2;
+	kernel.resize(size);
+	for (int i = 0; i < size; i++){
+		double u = (double)i / RESAMPLE_PHASES;
+		if (u >= reach){kernel[i] = 0; continue;}
+		double a = 2 * M_PI * cutoff * u;
+		double sinc = (u == 0) ? 1 : sin(a) / a;
+		double w = 0.42 + 0.5 * cos(M_PI * u / reach) + 0.08 * cos(2 * M_PI * u / reach);	// Blackman, centred
+		kernel[i] = (float)(2 * cutoff * sinc * w);
+	}
+}
+
+float Resampler::kernelAt(double u){
+	if (u < 0){u = -u;}
+	double position = u * RESAMPLE_PHASES;
+	int i = (int)position;
+	if (i + 1 >= (int)kernel.size()){return 0;}
+	float fraction = (float)(position - i);
+	return kernel[i] + fraction * (kernel[i + 1] - kernel[i]);
+}
+
+/* push function
+	Inputs must come in time order; a sample that does not move
+	time forward is dropped.
+*/
+void Resampler::push(long long timestamp, float x, float y, float z){
+	if (!times.empty()){
+		long long last = times.back();
+		if (timestamp <= last){return;}
+		if (!inputGiven){												// Running estimate, steady after a few inputs
+			double interval = (double)(timestamp - last);
+			inputPeriod = inputPeriod > 0 ? inputPeriod + (interval - inputPeriod) / 64 : interval;
+		}
+	}
+	else if (gridStart < 0){
+		gridStart = (long long)(ceil(timestamp / outputPeriod) * outputPeriod);	// First grid point at or after the first input
+	}
+	times.push_back(timestamp);
+	xs.push_back(x);
+	ys.push_back(y);
+	zs.push_back(z);
+}
+
+void Resampler::push(const RawSample *samples, size_t count){
+	for (size_t i = 0; i < count; i++){
+		const unsigned char *d = samples[i].data;
+		push(samples[i].sampleTime, (short)(d[1] << 8 | d[0]) >> 2, (short)(d[3] << 8 | d[2]) >> 2, (short)(d[5] << 8 | d[4]) >> 2);
+	}
+}
+
+long long Resampler::getLatency(){
+	if (method == RESAMPLE_LINEAR || inputPeriod <= 0){return 0;}
+	if (kernel.empty()){buildKernel();}
+	return (long long)(reach * inputPeriod);
+}
+
+/* interpolate function
+	Straight line between the two inputs around t.
+*/
+void Resampler::interpolate(long long t, ResampledSample &out){
+	double span = (double)(times[first + 1] - times[first]);
+	float f = (float)((t - times[first]) / span);
+	out.x = xs[first] + f * (xs[first + 1] - xs[first]);
+	out.y = ys[first] + f * (ys[first + 1] - ys[first]);
+	out.z = zs[first] + f * (zs[first + 1] - zs[first]);
+}
+
+/* produce function
+	Computes the next grid point if every input it depends on has
+	arrived, and moves past inputs no later output needs. Inside a
+	gap wider than the kernel there is nothing for the sinc to
+	weigh, so those outputs are interpolated linearly across it.
+*/
+bool Resampler::produce(ResampledSample &out){
+	if (times.size() - first < 2 || inputPeriod <= 0){return false;}
+	long long t = gridTime(emitted);
+	size_t n = times.size();
+
+	while (first + 1 < n && times[first + 1] <= t){first++;}		// times[first] <= t < times[first + 1]
+	if (first + 1 >= n){return false;}								// Nothing after t yet
+
+	out.timestamp = t;
+	if (method == RESAMPLE_LINEAR){
+		interpolate(t, out);
+		emitted++;
+		return true;
+	}
+
+	if (kernel.empty()){
+		if (!inputGiven && n < RESAMPLE_TAPS){return false;}		// Let the period estimate settle first
+		buildKernel();
+	}
+	long long horizon = (long long)(reach * inputPeriod);
+	if (times[n - 1] < t + horizon){return false;}					// Right half of the window incomplete
+	if (t - times[first] >= horizon && times[first + 1] - t >= horizon){	// No input within reach
+		interpolate(t, out);
+		emitted++;
+		return true;
+	}
+
+	// Left edge of the window: inputs still needed by this output, kept for the next ones too
+	size_t low = first;
+	while (low > 0 && times[low - 1] > t - horizon){low--;}
+	size_t high = first + 1;
+	while (high + 1 < n && times[high + 1] < t + horizon){high++;}
+	size_t count = high - low + 1;
+
+	weights.resize(count);
+	float total = 0;
+	for (size_t j = 0; j < count; j++){
+		weights[j] = kernelAt((times[low + j] - t) / inputPeriod);
+		total += weights[j];
+	}
+	if (total <= 0){												// Only sidelobes in reach, no gain to normalise
+		interpolate(t, out);
+		emitted++;
+		return true;
+	}
+
+	const float *w = &weights[0];
+	const float *x = &xs[low], *y = &ys[low], *z = &zs[low];
+	float sx = 0, sy = 0, sz = 0;
+	for (size_t j = 0; j < count; j++){								// Vectorisable
+		sx += w[j] * x[j];
+		sy += w[j] * y[j];
+		sz += w[j] * z[j];
+	}
+	out.x = sx / total;
+	out.y = sy / total;
+	out.z = sz / total;
+	emitted++;
+	return true;
+}
+
+/* compact function
+	Drops inputs older than any remaining output can use, in bulk
+	so the arrays stay contiguous without a memmove per sample.
+*/
+void Resampler::compact(){
+	size_t keep = first;
+	if (method == RESAMPLE_SINC){
+		if (kernel.empty()){return;}								// reach not known yet
+		long long t = gridTime(emitted);
+		long long horizon = (long long)(reach * inputPeriod);
+		while (keep > 0 && times[keep - 1] > t - horizon){keep--;}
+	}
+	if (keep < RESAMPLE_KEEP){return;}
+	times.erase(times.begin(), times.begin() + keep);
+	xs.erase(xs.begin(), xs.begin() + keep);
+	ys.erase(ys.begin(), ys.begin() + keep);
+	zs.erase(zs.begin(), zs.begin() + keep);
+	first -= keep;
+}
+
+size_t Resampler::pull(ResampledSample *out, size_t max){
+	size_t n = 0;
+	while (n < max && produce(out[n])){n++;}
+	compact();
+	return n;
+}
+
+#endif /* RESAMPLER_H_ */
@@ -0,0 +1,256 @@
+/* Rolling Writer Header File
+
+	Moves SegmentWriter.h off the thread that drains the sensors.
+	Appending to a mapped segment is only a memcpy, but committing
+	(msync, fdatasync) and rotating (posix_fallocate, ftruncate,
+	fsync) wait for the card, and while the draining thread waits
+	the session rings fill and drop samples.
+
+	write() copies an encoded block into one of a fixed set of slots
+	and queues it; the writer's own thread appends the queued blocks
+	in order. commit() asks the thread to commit once every block
+	queued before it is appended. When every slot is queued the
+	producer waits for one, counted as a stall, as in CaptureWriter.h.
+
+	A segment that cannot be started is retried by SEGMENT_APPEND;
+	the thread reports the outage once and again when it ends.
+
+		RollingWriter writer;
+		writer.open("Capture-2-0x19", 4 << 20, 60);	// 4 MB or 60 s segments
+		writer.write(block, size);					// From the draining thread
+		writer.commit();							// Once a second
+		writer.close();
+		writer.report(stdout);						// Segments, commits, slowest calls, stalls
+
+	Needs -std=c++11 -pthread.
+*/
+
+#ifndef ROLLINGWRITER_H_
+#define ROLLINGWRITER_H_
+
+#include "SegmentWriter.h"
+#include "TraceRecorder.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#define ROLLING_SLOTS	64		// Encoded blocks that may wait for the thread
+
+/* RollingWriter class definition
+	One segment prefix, its block slots and the thread that appends
+	and commits them.
+*/
+class RollingWriter {
+
+	private:
+		struct Slot {
+			unsigned char data[CODEC_MAX_BLOCK];
+			size_t size;
+		};
+
+		std::vector<Slot> slots;
+		segment_writer segments;				// The thread's alone between open() and close()
+		bool started;
+
+		std::thread worker;
+		std::mutex lock;						// Guards everything below
+		std::condition_variable queued;			// full has a slot, a commit is wanted or stopping is set
+		std::condition_variable freed;			// spare has a slot
+		std::deque<int> full;					// Waiting for the thread, oldest first
+		std::vector<int> spare;
+		bool committing;						// commit() called since the thread last looked
+		bool stopping;
+
+		unsigned long blocks;					// Appended
+		unsigned long long bytes;				// ...
+		int maxDepth;
+		unsigned long stalls;					// Writes that waited for a slot
+		long long stallTime;					// Nanoseconds spent waiting
+		unsigned long errors;					// Appends and commits the card refused
+		long long longestAppend;				// Nanoseconds, a rotation included
+		long long longestCommit;				// ...
+
+		static long long now();
+		void append(const Slot &slot);
+		void run();
+
+		RollingWriter(const RollingWriter&);				// Not copyable
+		RollingWriter& operator=(const RollingWriter&);	// ...
+
+	public:
+		RollingWriter(int slotCount = ROLLING_SLOTS);
+		~RollingWriter();
+
+		int  open(const char *prefix, size_t capacity, double rotateEvery);	// Recovers, starts the first segment and the thread, 0 on success
+		void write(const void *block, size_t size);	// One whole encoded block
+		void commit();							// Makes everything written so far durable, on the thread
+		int  close();							// Appends the rest, closes the segment and joins, 0 if nothing was lost
+
+		unsigned long getRecovered() { return segments.recovered; }	// Segments found open by open()
+		void report(FILE *out);					// One line of the above
+};
+
+RollingWriter::RollingWriter(int slotCount)
+	: started(false), committing(false), stopping(false), blocks(0), bytes(0), maxDepth(0),
+	  stalls(0), stallTime(0), errors(0), longestAppend(0), longestCommit(0) {
+	if (slotCount < 2){slotCount = 2;}
+	slots.resize(slotCount);
+	memset(&segments, 0, sizeof(segments));
+	segments.fd = segments.commitFd = -1;
+}
+
+RollingWriter::~RollingWriter(){
+	close();
+}
+
+long long RollingWriter::now(){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* open function
+*/
+int RollingWriter::open(const char *prefix, size_t capacity, double rotateEvery){
+	if (started){return -1;}
+	if (SEGMENT_OPEN(&segments, prefix, capacity, 0, rotateEvery) != 0){return -1;}
+	full.clear();
+	spare.clear();
+	for (int s = (int)slots.size() - 1; s >= 0; s--){spare.push_back(s);}
+	committing = stopping = false;
+	started = true;
+	worker = std::thread(&RollingWriter::run, this);
+	return 0;
+}
+
+/* write function
+	Copies the block for the thread, waiting for a slot when all are
+	queued. A block larger than a slot is counted as an error.
+*/
+void RollingWriter::write(const void *block, size_t size){
+	if (!started){return;}
+	std::unique_lock<std::mutex> guard(lock);
+	if (size > CODEC_MAX_BLOCK){
+		errors++;
+		return;
+	}
+	if (spare.empty()){
+		TRACE_SCOPE("segment stall");
+		long long began = now();
+		freed.wait(guard, [this]{ return !spare.empty(); });
+		stalls++;
+		stallTime += now() - began;
+	}
+	int s = spare.back();
+	spare.pop_back();
+	guard.unlock();
+	memcpy(slots[s].data, block, size);					// The slot is the producer's until queued
+	slots[s].size = size;
+	guard.lock();
+	full.push_back(s);
+	if ((int)full.size() > maxDepth){maxDepth = (int)full.size();}
+	queued.notify_one();
+}
+
+/* commit function
+*/
+void RollingWriter::commit(){
+	if (!started){return;}
+	std::lock_guard<std::mutex> guard(lock);
+	committing = true;
+	queued.notify_one();
+}
+
+/* append function
+	One block into the segments, on the thread. The outage of a
+	failed start is reported when it begins and when it ends.
+*/
+void RollingWriter::append(const Slot &slot){
+	int failed = segments.failed;
+	long long began = now();
+	int result = SEGMENT_APPEND(&segments, slot.data, slot.size);
+	long long took = now() - began;
+	if (segments.failed && !failed){printf("Error: Trouble starting %s segment %d, retrying.\n", segments.prefix, segments.number + 1);}
+	else if (failed && !segments.failed){printf("%s segments resumed, %lu blocks lost so far.\n", segments.prefix, segments.lost);}
+	else if (result != 0 && !segments.failed){printf("Error: Trouble writing %s segments.\n", segments.prefix);}
+
+	std::lock_guard<std::mutex> guard(lock);
+	if (result == 0){
+		blocks++;
+		bytes += slot.size;
+	}
+	else{errors++;}
+	if (took > longestAppend){longestAppend = took;}
+}
+
+/* run function
+	The writer thread. Appends every queued block, then commits if
+	asked to before it took them, until close() has nothing left.
+*/
+void RollingWriter::run(){
+	if (traceRecorder().isEnabled()){traceRecorder().nameThread("segments");}
+	std::vector<int> batch;
+	batch.reserve(slots.size());
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;){
+		queued.wait(guard, [this]{ return !full.empty() || committing || stopping; });
+		if (full.empty() && !committing){break;}			// Stopping, all appended
+		batch.assign(full.begin(), full.end());
+		full.clear();
+		bool commitNow = committing;						// Covers every block in batch
+		committing = false;
+		guard.unlock();
+
+		TRACE_BEGIN("segment append");
+		for (size_t i = 0; i < batch.size(); i++){append(slots[batch[i]]);}
+		TRACE_END("segment append");
+		long long took = 0;
+		int result = 0;
+		if (commitNow){
+			TRACE_SCOPE("segment commit");
+			long long began = now();
+			result = SEGMENT_COMMIT(&segments);
+			took = now() - began;
+		}
+
+		guard.lock();
+		for (size_t i = 0; i < batch.size(); i++){spare.push_back(batch[i]);}
+		if (result != 0){errors++;}
+		if (took > longestCommit){longestCommit = took;}
+		freed.notify_one();
+	}
+}
+
+/* close function
+*/
+int RollingWriter::close(){
+	if (!started){return 0;}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+		queued.notify_one();
+	}
+	worker.join();
+	started = false;
+	if (SEGMENT_CLOSE(&segments) != 0){errors++;}
+	return (errors == 0 && segments.lost == 0) ? 0 : -1;
+}
+
+/* report function
+*/
+void RollingWriter::report(FILE *out){
+	std::lock_guard<std::mutex> g(lock);
+	fprintf(out, "%lu written\t%lu commits\t%.2f MB\tlongest append %.1f ms, commit %.1f ms\tqueue %d of %zu max\t%lu stalls %.1f ms",
+		segments.segments, segments.commits, bytes / 1048576.0, longestAppend / 1e6, longestCommit / 1e6,
+		maxDepth, slots.size(), stalls, stallTime / 1e6);
+	if (segments.failures > 0){fprintf(out, "\t%lu failed starts\t%lu blocks lost", segments.failures, segments.lost);}
+	if (errors > 0){fprintf(out, "\t%lu errors", errors);}
+	fprintf(out, "\n");
+}
+
+#endif /* ROLLINGWRITER_H_ */
@@ -0,0 +1,198 @@
+/* Sample Clock Header File
+
+	Per-sample timestamps. The entry number (time_sig = read_count)
+	only becomes a time if every read is exactly 1/refresh_rate
+	apart, which usleep, popen and the scheduler never allow, and
+	the sensor's own oscillator is not exactly at its nominal ODR
+	either.
+
+	Every read is stamped with CLOCK_MONOTONIC_RAW, which NTP does
+	not slew. The host stamps are then fitted against the sensor's
+	sample number with an online least squares line,
+
+		host time = offset + period * sample number
+
+	weighted so that old reads fade out (CLOCK_FORGET), which follows
+	the oscillator as it drifts with temperature. The line gives
+	each sample the time the sensor latched it plus the constant
+	mean read delay, without the jitter of the individual reads.
+
+	The sample number comes from what the read says about itself:
+
+		status poll		ZYXDA clear: no new sample, not fitted
+						ZYXDA set: one new sample
+						ZYXOR set as well: more than one, how many
+						is worked out from the time since the last
+						one and the fitted period
+		FIFO batch		FSS samples, the newest read last; OVRN
+						means some were lost, counted as above
+
+	Only reads that account for every sample since the last one are
+	fitted. After an overrun the read could have come any time in
+	the period after the newest sample, and when every read overruns
+	(polling slower than the ODR) nothing in the host times shows
+	the sensor's clock: the samples are then spaced at the nominal
+	period. Poll faster than the ODR, or read the FIFO, to see it.
+
+	Counting lost samples needs the period, and the first few reads
+	are too close together to measure it, so the fit starts out held
+	to the nominal period, as firmly as CLOCK_TOLERANCE says the
+	oscillator can be off, and lets go as the reads spread out.
+
+	Reads that land far from the line (preempted, a slow popen)
+	still advance the sample number but are not fitted.
+
+	Plain C, shared by READ.c, PARSE.c and the C++ driver.
+*/
+
+#ifndef SAMPLECLOCK_H_
+#define SAMPLECLOCK_H_
+
+#include <stdio.h>
+#include <time.h>
+
+#define CLOCK_FORGET	0.999	// Weight a fit keeps per read, about the last 1000 reads count
+#define CLOCK_GATE		5.0		// Residuals past this many times the jitter are not fitted
+#define CLOCK_GATE_MIN	1000.0	// ... or past this many ns, whichever is larger
+#define CLOCK_WARMUP	16		// Reads fitted before the gate applies
+#define CLOCK_TOLERANCE	0.02	// Expected ODR error, holds the first fits near the nominal period
+
+/* sample_clock structure
+	Fit state for one sensor. Host times are kept relative to the
+	first read so the doubles keep nanosecond resolution.
+*/
+struct sample_clock{
+	double nominal;				// Period from the configured ODR, ns, 0 if unknown
+	double period;				// Fitted period, ns
+	double offset;				// Fitted host time of sample 0, ns after origin
+	long long origin;			// CLOCK_MONOTONIC_RAW of the first read
+	unsigned long long index;	// Number of the newest sample seen, the first is 0
+	double weight;				// Regression sums, exponentially weighted
+	double meanIndex, meanTime;
+	double varIndex, covariance;
+	double jitter;				// Mean absolute residual of the reads, ns
+	unsigned long observations;	// Reads that brought new samples
+	unsigned long rejected;		// ... of which were too far off to fit
+};
+typedef struct sample_clock sample_clock;	// Define type for sample_clock
+
+/* SAMPLE_NOW function
+	CLOCK_MONOTONIC_RAW in nanoseconds.
+*/
+static inline long long SAMPLE_NOW (void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* CLOCK_INIT function
+	Starts a new fit for a sensor running at rate Hz, 0 if the
+	rate is unknown (the fit then assumes no samples are lost until
+	it has a period of its own).
+*/
+static inline void CLOCK_INIT (sample_clock *clock, double rate){
+	clock->nominal = rate > 0 ? 1e9 / rate : 0;
+	clock->period = clock->nominal;
+	clock->offset = 0;
+	clock->origin = 0;
+	clock->index = 0;
+	clock->weight = 0;
+	clock->meanIndex = 0;
+	clock->meanTime = 0;
+	clock->varIndex = 0;
+	clock->covariance = 0;
+	clock->jitter = 0;
+	clock->observations = 0;
+	clock->rejected = 0;
+}
+
+/* CLOCK_ROUND function
+	Nearest integer, without needing libm for READ.c.
+*/
+static inline long long CLOCK_ROUND (double value){
+	return (long long)(value < 0 ? value - 0.5 : value + 0.5);
+}
+
+/* CLOCK_STAMP function
+	Fitted CLOCK_MONOTONIC_RAW time of sample index.
+*/
+static inline long long CLOCK_STAMP (const sample_clock *clock, unsigned long long index){
+	return clock->origin + CLOCK_ROUND(clock->offset + clock->period * (double)index);
+}
+
+/* CLOCK_OBSERVE function
+	Accounts one read made at host time, which returned samples new
+	samples, the last of them the newest. exact is 0 if the sensor
+	reported a loss (ZYXOR, OVRN), so more samples passed than were
+	read. Returns the number of the newest sample.
+*/
+static inline unsigned long long CLOCK_OBSERVE (sample_clock *clock, long long host, int samples, int exact){
+	if (samples <= 0){return clock->index;}				// Duplicate, nothing new to fit
+	if (clock->observations == 0){
+		clock->origin = host;
+		clock->index = samples - 1;
+		clock->offset = -clock->period * (double)clock->index;
+	}
+	else{
+		long long passed = samples;
+		if (!exact){
+			passed = samples + 1;						// At least one lost
+			if (clock->period > 0){
+				long long guess = CLOCK_ROUND((host - CLOCK_STAMP(clock, clock->index)) / clock->period);
+				if (guess > passed){passed = guess;}
+			}
+		}
+		clock->index += passed;
+	}
+	clock->observations++;
+	if (!exact && clock->weight > 0){return clock->index;}	// Unknown delay, see above
+
+	double x = (double)clock->index;
+	double y = (double)(host - clock->origin);
+	double residual = y - (clock->offset + clock->period * x);
+	if (residual < 0){residual = -residual;}
+	double gate = CLOCK_GATE * clock->jitter > CLOCK_GATE_MIN ? CLOCK_GATE * clock->jitter : CLOCK_GATE_MIN;
+	if (clock->observations > 1){								// Clamped, so a long stall cannot blow the gate open
+		clock->jitter += ((residual < gate ? residual : gate) - clock->jitter) / 16;
+	}
+	if (clock->observations > CLOCK_WARMUP && residual > gate){
+		clock->rejected++;								// Late read, keep it out of the fit
+		return clock->index;
+	}
+
+	double dx = x - clock->meanIndex;
+	clock->weight = clock->weight * CLOCK_FORGET + 1;
+	clock->meanIndex += dx / clock->weight;
+	clock->meanTime += (y - clock->meanTime) / clock->weight;
+	clock->varIndex = clock->varIndex * CLOCK_FORGET + dx * (x - clock->meanIndex);
+	clock->covariance = clock->covariance * CLOCK_FORGET + dx * (y - clock->meanTime);
+
+	// Ridge towards the nominal period: the read delay is spread over about one period,
+	// variance period^2 / 12, against a prior of CLOCK_TOLERANCE * period
+	double prior = clock->nominal > 0 ? 1.0 / (12 * CLOCK_TOLERANCE * CLOCK_TOLERANCE) : 0;
+	if (clock->varIndex + prior > 0){
+		clock->period = (clock->covariance + prior * clock->nominal) / (clock->varIndex + prior);
+	}
+	clock->offset = clock->meanTime - clock->period * clock->meanIndex;
+	return clock->index;
+}
+
+/* CLOCK_DRIFT_PPM function
+	How far the fitted rate is from the nominal one, in parts per
+	million. Positive means the sensor runs fast.
+*/
+static inline double CLOCK_DRIFT_PPM (const sample_clock *clock){
+	if (clock->nominal <= 0 || clock->period <= 0){return 0;}
+	return (clock->nominal / clock->period - 1) * 1e6;
+}
+
+/* CLOCK_PRINT function
+	One line summary of a fit.
+*/
+static inline void CLOCK_PRINT (const sample_clock *clock, FILE *out){
+	fprintf(out, "%.1f Hz fitted\t%+.0f ppm\t%.1f us read jitter\t%lu reads\t%lu not fitted\n",
+		clock->period > 0 ? 1e9 / clock->period : 0.0, CLOCK_DRIFT_PPM(clock), clock->jitter / 1e3,
+		clock->observations, clock->rejected);
+}
+
+#endif /* SAMPLECLOCK_H_ */
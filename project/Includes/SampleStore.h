@@ -0,0 +1,357 @@
+/* Sample Store Header File
+
+	Keeps long runs of samples in RAM, compressed, and readable by
+	time. READ.c's linked list spends a malloc'd node of over 50
+	bytes on every sample, which fills the BeagleBone's 512 MB in a
+	few hours at a few hundred Hz; this holds the same samples in a
+	few bytes each.
+
+	Samples go into fixed blocks of STORE_BLOCK_BYTES, compressed in
+	the manner of Facebook's Gorilla (Pelkonen et al., VLDB 2015):
+
+		time		delta of delta, in a prefix code
+						0				0
+						10	  + 7 bits	-64 to 63
+						110	  + 9 bits	-256 to 255
+						1110  + 12 bits	-2048 to 2047
+						11110 + 32 bits	...
+						11111 + 64 bits	anything
+		sequence	0 for a step of one, else 1 + 32 bits
+		x, y, z		step from the axis' previous count
+						0				same count
+						10 + sign + bits	magnitude inside the
+										previous window
+						11 + sign + 4 + 4 + bits	new window:
+										leading zeros, length - 1,
+										bits
+
+	Gorilla XORs a value with the previous one and keeps only the
+	window between the leading and trailing zeros. On two's
+	complement counts the XOR of +1 and -1 is all ones, so an axis
+	resting near zero would cost 16 bits a sample; the window here
+	goes over the magnitude of the step instead, which keeps the
+	four trailing zeros of the left justified counts too.
+
+	The first sample of a block is kept whole in its header, so a
+	block decodes on its own and a scan can start at any block.
+	Blocks also record the earliest and latest time in them, and a
+	scan only decodes the blocks that overlap its range. Sample
+	times are expected to rise but need not: a refit of the sample
+	clock can move a stamp back a little, which only costs bits.
+
+	With a byte limit the oldest blocks are freed as new ones fill,
+	so the store always holds the latest limit's worth.
+
+	Not thread safe: the thread that drains the sessions owns it.
+	Appending can free blocks, so a cursor is only good until the
+	next append to a limited store.
+
+	Plain C, samples are the codec_samples of CaptureCodec.h.
+*/
+
+#ifndef SAMPLESTORE_H_
+#define SAMPLESTORE_H_
+
+#include "CaptureCodec.h"
+
+#include <stdlib.h>
+
+#define STORE_BLOCK_BYTES	4096							// Compressed payload per block
+#define STORE_BLOCK_BITS	(STORE_BLOCK_BYTES * 8)
+#define STORE_SAMPLE_BITS	(5 + 64 + 1 + 32 + 3 * (3 + 4 + 4 + 16))	// Longest a sample can encode to
+
+/* store_block structure
+	One block of compressed samples, oldest first in a list.
+*/
+struct store_block{
+	struct store_block *next;	// Newer block, NULL for the newest
+	codec_sample first;			// Kept whole
+	int64_t low, high;			// Earliest and latest time in the block
+	uint32_t count;				// Samples, with the first
+	uint32_t bits;				// Payload bits used
+	uint64_t words[STORE_BLOCK_BYTES / 8];	// Payload, most significant bit first
+};
+typedef struct store_block store_block;	// Define type for store_block
+
+/* store_state structure
+	What the encoder and decoder carry from sample to sample. Both
+	start over at every block.
+*/
+struct store_state{
+	codec_sample previous;
+	int64_t delta;				// Previous time step
+	uint8_t lead[3], length[3];	// Window of the previous step, per axis
+};
+typedef struct store_state store_state;	// Define type for store_state
+
+/* sample_store structure
+*/
+struct sample_store{
+	store_block *oldest, *newest;
+	store_state state;			// Encoder, at the end of newest
+	size_t limit;				// Bytes of blocks kept, 0 for no limit
+	size_t blocks;
+	unsigned long long samples;	// Held now
+	unsigned long long dropped;	// Freed to stay under the limit
+};
+typedef struct sample_store sample_store;	// Define type for sample_store
+
+/* store_cursor structure
+	Position of a scan.
+*/
+struct store_cursor{
+	const store_block *block;
+	uint32_t index;				// Next sample of the block
+	uint32_t bit;				// ... and where it starts
+	store_state state;
+};
+typedef struct store_cursor store_cursor;	// Define type for store_cursor
+
+/* STORE_INIT function
+	Starts an empty store holding at most limit bytes, 0 for no
+	limit.
+*/
+static inline void STORE_INIT (sample_store *store, size_t limit){
+	memset(store, 0, sizeof(*store));
+	store->limit = limit;
+}
+
+/* STORE_FREE function
+	Frees every block, leaving an empty store.
+*/
+static inline void STORE_FREE (sample_store *store){
+	while (store->oldest != NULL){
+		store_block *next = store->oldest->next;
+		free(store->oldest);
+		store->oldest = next;
+	}
+	STORE_INIT(store, store->limit);
+}
+
+/* STORE_BYTES function
+	Memory held by the blocks.
+*/
+static inline size_t STORE_BYTES (const sample_store *store){
+	return store->blocks * sizeof(store_block);
+}
+
+/* STORE_PUT function
+	Appends the low n bits of value, n up to 64.
+*/
+static inline void STORE_PUT (store_block *block, uint64_t value, int n){
+	if (n == 0){return;}
+	if (n < 64){value &= ((uint64_t)1 << n) - 1;}
+	uint32_t word = block->bits >> 6;
+	int room = 64 - (block->bits & 63);
+	if (n <= room){block->words[word] |= value << (room - n);}
+	else{
+		block->words[word] |= value >> (n - room);
+		block->words[word + 1] |= value << (64 - (n - room));
+	}
+	block->bits += n;
+}
+
+/* STORE_GET function
+	Reads n bits, n up to 64, moving bit past them.
+*/
+static inline uint64_t STORE_GET (const store_block *block, uint32_t *bit, int n){
+	if (n == 0){return 0;}
+	uint32_t word = *bit >> 6;
+	int offset = *bit & 63;
+	uint64_t value = block->words[word] << offset;
+	if (offset + n > 64){value |= block->words[word + 1] >> (64 - offset);}
+	*bit += n;
+	return value >> (64 - n);
+}
+
+/* STORE_SIGNED function
+	Sign extends the low n bits.
+*/
+static inline int64_t STORE_SIGNED (uint64_t value, int n){
+	return n == 64 ? (int64_t)value : (int64_t)(value << (64 - n)) >> (64 - n);
+}
+
+/* STORE_START function
+	State after the first sample of a block.
+*/
+static inline void STORE_START (store_state *state, const codec_sample *first){
+	memset(state, 0, sizeof(*state));
+	state->previous = *first;					// No windows yet, length 0
+}
+
+/* STORE_ENCODE function
+	Appends sample after state to block.
+*/
+static inline void STORE_ENCODE (store_block *block, store_state *state, const codec_sample *sample){
+	int64_t delta = sample->time - state->previous.time;
+	int64_t dod = delta - state->delta;
+	if (dod == 0){STORE_PUT(block, 0, 1);}
+	else if (dod >= -64 && dod < 64){STORE_PUT(block, 0x2, 2); STORE_PUT(block, dod, 7);}
+	else if (dod >= -256 && dod < 256){STORE_PUT(block, 0x6, 3); STORE_PUT(block, dod, 9);}
+	else if (dod >= -2048 && dod < 2048){STORE_PUT(block, 0xE, 4); STORE_PUT(block, dod, 12);}
+	else if (dod >= INT32_MIN && dod <= INT32_MAX){STORE_PUT(block, 0x1E, 5); STORE_PUT(block, dod, 32);}
+	else{STORE_PUT(block, 0x1F, 5); STORE_PUT(block, dod, 64);}
+	state->delta = delta;
+
+	uint32_t step = sample->sequence - state->previous.sequence;
+	if (step == 1){STORE_PUT(block, 0, 1);}
+	else{STORE_PUT(block, 1, 1); STORE_PUT(block, step, 32);}
+
+	for (int a = 0; a < 3; a++){
+		int16_t change = (int16_t)(sample->axis[a] - state->previous.axis[a]);	// Wraps, so it fits 16 bits
+		if (change == 0){
+			STORE_PUT(block, 0, 1);
+			continue;
+		}
+		unsigned int magnitude = change < 0 ? -(int)change : change;
+		int lead = __builtin_clz(magnitude) - 16, trail = __builtin_ctz(magnitude);
+		int oldTrail = 16 - state->lead[a] - state->length[a];
+		if (state->length[a] > 0 && lead >= state->lead[a] && trail >= oldTrail){
+			STORE_PUT(block, 0x4 | (change < 0), 3);
+			STORE_PUT(block, magnitude >> oldTrail, state->length[a]);
+		}
+		else{
+			int length = 16 - lead - trail;
+			STORE_PUT(block, 0x6 | (change < 0), 3);
+			STORE_PUT(block, lead, 4);
+			STORE_PUT(block, length - 1, 4);
+			STORE_PUT(block, magnitude >> trail, length);
+			state->lead[a] = (uint8_t)lead;
+			state->length[a] = (uint8_t)length;
+		}
+	}
+	state->previous = *sample;
+}
+
+/* STORE_DECODE function
+	Reads the sample after state from block at bit.
+*/
+static inline void STORE_DECODE (const store_block *block, uint32_t *bit, store_state *state, codec_sample *sample){
+	int64_t dod;
+	if (STORE_GET(block, bit, 1) == 0){dod = 0;}
+	else if (STORE_GET(block, bit, 1) == 0){dod = STORE_SIGNED(STORE_GET(block, bit, 7), 7);}
+	else if (STORE_GET(block, bit, 1) == 0){dod = STORE_SIGNED(STORE_GET(block, bit, 9), 9);}
+	else if (STORE_GET(block, bit, 1) == 0){dod = STORE_SIGNED(STORE_GET(block, bit, 12), 12);}
+	else if (STORE_GET(block, bit, 1) == 0){dod = STORE_SIGNED(STORE_GET(block, bit, 32), 32);}
+	else{dod = (int64_t)STORE_GET(block, bit, 64);}
+	state->delta += dod;
+	sample->time = state->previous.time + state->delta;
+
+	uint32_t step = STORE_GET(block, bit, 1) ? (uint32_t)STORE_GET(block, bit, 32) : 1;
+	sample->sequence = state->previous.sequence + step;
+
+	for (int a = 0; a < 3; a++){
+		unsigned int magnitude = 0;
+		int negative = 0;
+		if (STORE_GET(block, bit, 1)){
+			int fresh = (int)STORE_GET(block, bit, 1);
+			negative = (int)STORE_GET(block, bit, 1);
+			if (fresh){
+				state->lead[a] = (uint8_t)STORE_GET(block, bit, 4);
+				state->length[a] = (uint8_t)(STORE_GET(block, bit, 4) + 1);
+			}
+			int trail = 16 - state->lead[a] - state->length[a];
+			magnitude = (unsigned int)STORE_GET(block, bit, state->length[a]) << trail;
+		}
+		uint16_t change = (uint16_t)(negative ? -magnitude : magnitude);
+		sample->axis[a] = (int16_t)((uint16_t)state->previous.axis[a] + change);
+	}
+	state->previous = *sample;
+}
+
+/* STORE_APPEND function
+	Adds a sample after every sample held. Returns -1 if no
+	memory for a new block, 0 otherwise.
+*/
+static inline int STORE_APPEND (sample_store *store, const codec_sample *sample){
+	store_block *block = store->newest;
+	if (block != NULL && block->bits + STORE_SAMPLE_BITS <= STORE_BLOCK_BITS){
+		STORE_ENCODE(block, &store->state, sample);
+		if (sample->time < block->low){block->low = sample->time;}
+		if (sample->time > block->high){block->high = sample->time;}
+		block->count++;
+		store->samples++;
+		return 0;
+	}
+
+	block = (store_block *)calloc(1, sizeof(store_block));	// First, or the newest is full
+	if (block == NULL){return -1;}
+	block->first = *sample;
+	block->low = block->high = sample->time;
+	block->count = 1;
+	STORE_START(&store->state, sample);
+	if (store->newest != NULL){store->newest->next = block;}
+	else{store->oldest = block;}
+	store->newest = block;
+	store->blocks++;
+	store->samples++;
+
+	while (store->limit > 0 && STORE_BYTES(store) > store->limit && store->oldest != block){
+		store_block *oldest = store->oldest;
+		store->oldest = oldest->next;
+		store->samples -= oldest->count;
+		store->dropped += oldest->count;
+		store->blocks--;
+		free(oldest);
+	}
+	return 0;
+}
+
+/* STORE_SEEK function
+	Points cursor at the first block whose samples reach from.
+	STORE_NEXT still returns the earlier samples of that block, the
+	caller skips them.
+*/
+static inline void STORE_SEEK (const sample_store *store, store_cursor *cursor, int64_t from){
+	const store_block *block = store->oldest;
+	while (block != NULL && block->high < from){block = block->next;}
+	cursor->block = block;
+	cursor->index = 0;
+	cursor->bit = 0;
+}
+
+/* STORE_NEXT function
+	Reads the sample at cursor and moves past it. Returns 0 once
+	there are no more.
+*/
+static inline int STORE_NEXT (store_cursor *cursor, codec_sample *sample){
+	const store_block *block = cursor->block;
+	if (block == NULL){return 0;}
+	if (cursor->index == 0){
+		*sample = block->first;
+		STORE_START(&cursor->state, sample);
+	}
+	else{STORE_DECODE(block, &cursor->bit, &cursor->state, sample);}
+	if (++cursor->index == block->count){
+		cursor->block = block->next;
+		cursor->index = 0;
+		cursor->bit = 0;
+	}
+	return 1;
+}
+
+/* STORE_SCAN function
+	Copies the samples from from to to, both included, into out,
+	at most max of them, in the order they were appended. Returns
+	how many.
+*/
+static inline size_t STORE_SCAN (const sample_store *store, int64_t from, int64_t to, codec_sample *out, size_t max){
+	store_cursor cursor;
+	codec_sample sample;
+	size_t n = 0;
+	STORE_SEEK(store, &cursor, from);
+	while (n < max && cursor.block != NULL){
+		const store_block *block = cursor.block;
+		if (block->low > to){break;}				// Later blocks are later still
+		if (block->high < from){					// Nothing in range, skip it whole
+			cursor.block = block->next;
+			continue;
+		}
+		while (n < max && cursor.block == block && STORE_NEXT(&cursor, &sample)){
+			if (sample.time >= from && sample.time <= to){out[n++] = sample;}
+		}
+	}
+	return n;
+}
+
+#endif /* SAMPLESTORE_H_ */
@@ -0,0 +1,395 @@
+/* Segment Writer Header File
+
+	Writes compressed capture blocks (CaptureCodec.h) so that a
+	crash or power cut loses at most the last commit interval, not
+	the run. PDUMP only writes at the end and stdio buffers whatever
+	it likes, so neither survives the BeagleBone losing power.
+
+	Blocks go into segment files, <prefix>-<number>.lsm, that are
+	preallocated to their full size and mapped, so appending is a
+	memcpy with no system call. Every commitEvery seconds, or when
+	asked, the writer commits:
+
+		1. msync the bytes appended since the last commit
+		2. write a commit record: the committed length and a CRC-32
+		   of those new bytes, in <prefix>-<number>.commit
+		3. fdatasync the commit file
+
+	so a commit record only ever names data that is already on the
+	card. The commit file has two record slots written in turn, each
+	with a CRC of its own, so a record torn by the power cut leaves
+	the previous one intact.
+
+	A segment is closed, and the next one started, once the next
+	block would not fit or rotateEvery seconds have passed. Closing
+	trims the file to its committed length, after which it is an
+	ordinary capture for REPLAY, QUERY and CaptureIndex.h.
+
+	If the next segment cannot be started (card full, or pulled)
+	the blocks appended meanwhile are counted as lost and the start
+	is tried again by a later append, SEGMENT_RETRY seconds after
+	the failure and twice as long after each further one, up to
+	SEGMENT_RETRY_MAX. The number is reused, so segments stay
+	contiguous for SEGMENT_OPEN.
+
+	Recovery (SEGMENT_RECOVER, run by SEGMENT_OPEN on every segment
+	of the prefix left open) reads the two slots, takes the newest
+	whole one and checks only the bytes it added against its CRC;
+	if they did not all reach the card it falls back to the older
+	slot, which was synced before the newer one was begun. Nothing
+	before that is read again. The file is trimmed to the committed
+	length and anything after it, never committed, is dropped.
+
+	Not thread safe, one writer per prefix.
+
+	Plain C, shared by the C programs and the C++ sessions.
+*/
+
+#ifndef SEGMENTWRITER_H_
+#define SEGMENTWRITER_H_
+
+#include "CaptureCodec.h"
+#include "SampleClock.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SEGMENT_MAGIC		0x54494D43		// "CMIT" in the commit file
+#define SEGMENT_SLOT		64				// Bytes per commit slot
+#define SEGMENT_PATH		256				// Longest segment path
+#define SEGMENT_CHECK_BUF	65536			// Read size when checking a commit
+#define SEGMENT_RETRY		1.0				// Seconds before a failed start is retried
+#define SEGMENT_RETRY_MAX	60.0			// ... at most, doubling in between
+
+/* segment_commit structure
+	One commit record.
+*/
+struct segment_commit{
+	uint32_t magic;				// SEGMENT_MAGIC
+	uint32_t closed;			// 1 once the segment is trimmed and final
+	uint64_t generation;		// Commits so far, the newest record wins
+	uint64_t length;			// Committed bytes of the segment
+	uint64_t previous;			// ... at the commit before
+	uint32_t crc;				// CRC-32 of the bytes from previous to length
+	uint32_t check;				// CRC-32 of the fields above
+};
+typedef struct segment_commit segment_commit;	// Define type for segment_commit
+
+/* segment_writer structure
+*/
+struct segment_writer{
+	char prefix[SEGMENT_PATH - 24];		// Room for -<number>.commit
+	int number;					// Of the open segment
+	int fd, commitFd;			// ... its data and commit files, -1 if none
+	unsigned char *map;			// Data file, capacity bytes
+	size_t capacity;			// Segment size
+	size_t length;				// Bytes appended
+	size_t committed;			// ... of which committed
+	uint32_t crc;				// Of the bytes from committed to length
+	uint64_t generation;		// Of the last commit
+	long long opened;			// SAMPLE_NOW when the segment was started
+	long long lastCommit;		// ... and last committed
+	double commitEvery;			// Seconds, 0 for only when asked
+	double rotateEvery;			// Seconds, 0 for only when full
+	unsigned long commits;		// Totals over every segment
+	unsigned long segments;		// ...
+	unsigned long recovered;	// Segments found open by SEGMENT_OPEN
+	int failed;					// The last SEGMENT_START failed, appends retry it
+	long long retryAt;			// SAMPLE_NOW of the next try
+	double retryDelay;			// Seconds after the next failure
+	unsigned long failures;		// Starts that failed
+	unsigned long lost;			// Blocks appended while no segment was open
+};
+typedef struct segment_writer segment_writer;	// Define type for segment_writer
+
+/* SEGMENT_CRC function
+	Continues the CRC-32 (IEEE) crc over size bytes, 0 to start.
+*/
+static inline uint32_t SEGMENT_CRC (uint32_t crc, const void *data, size_t size){
+	static uint32_t table[256];
+	static int ready = 0;
+	if (!ready){
+		for (uint32_t n = 0; n < 256; n++){
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++){c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;}
+			table[n] = c;
+		}
+		ready = 1;
+	}
+	const unsigned char *p = (const unsigned char *)data;
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++){crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);}
+	return ~crc;
+}
+
+/* SEGMENT_NAME function
+	Path of a segment's data (.lsm) or commit (.commit) file, -1 if
+	it does not fit SEGMENT_PATH.
+*/
+static inline int SEGMENT_NAME (char *path, const char *prefix, int number, const char *extension){
+	return snprintf(path, SEGMENT_PATH, "%s-%04d.%s", prefix, number, extension) < SEGMENT_PATH ? 0 : -1;
+}
+
+/* SEGMENT_READ_COMMIT function
+	Reads slot of a commit file, 0 if it holds a whole record.
+*/
+static inline int SEGMENT_READ_COMMIT (int fd, int slot, segment_commit *record){
+	if (pread(fd, record, sizeof(*record), slot * SEGMENT_SLOT) != (ssize_t)sizeof(*record)){return -1;}
+	if (record->magic != SEGMENT_MAGIC){return -1;}
+	return SEGMENT_CRC(0, record, offsetof(segment_commit, check)) == record->check ? 0 : -1;
+}
+
+/* SEGMENT_WRITE_COMMIT function
+	Writes and syncs a record into the slot its generation picks.
+*/
+static inline int SEGMENT_WRITE_COMMIT (int fd, segment_commit *record){
+	record->magic = SEGMENT_MAGIC;
+	record->check = SEGMENT_CRC(0, record, offsetof(segment_commit, check));
+	off_t at = (record->generation & 1) * SEGMENT_SLOT;
+	if (pwrite(fd, record, sizeof(*record), at) != (ssize_t)sizeof(*record)){return -1;}
+	return fdatasync(fd);
+}
+
+/* SEGMENT_CHECK_RANGE function
+	1 if the bytes from record->previous to record->length of the
+	data file match its CRC.
+*/
+static inline int SEGMENT_CHECK_RANGE (int fd, const segment_commit *record){
+	unsigned char buffer[SEGMENT_CHECK_BUF];
+	uint32_t crc = 0;
+	for (uint64_t at = record->previous; at < record->length; ){
+		size_t want = record->length - at < SEGMENT_CHECK_BUF ? (size_t)(record->length - at) : SEGMENT_CHECK_BUF;
+		ssize_t got = pread(fd, buffer, want, at);
+		if (got <= 0){return 0;}
+		crc = SEGMENT_CRC(crc, buffer, got);
+		at += got;
+	}
+	return crc == record->crc;
+}
+
+/* SEGMENT_RECOVER function
+	Brings segment number of prefix to its last good commit and
+	closes it. Returns its length, or -1 if there is no such
+	segment.
+*/
+static inline long long SEGMENT_RECOVER (const char *prefix, int number){
+	char path[SEGMENT_PATH];
+	SEGMENT_NAME(path, prefix, number, "commit");
+	int commitFd = open(path, O_RDWR);
+	SEGMENT_NAME(path, prefix, number, "lsm");
+	int fd = open(path, O_RDWR);
+	if (fd < 0 || commitFd < 0){
+		if (fd >= 0){close(fd);}
+		if (commitFd >= 0){close(commitFd);}
+		return -1;
+	}
+
+	segment_commit slots[2], good;
+	int valid[2];
+	memset(&good, 0, sizeof(good));
+	for (int s = 0; s < 2; s++){valid[s] = SEGMENT_READ_COMMIT(commitFd, s, &slots[s]) == 0;}
+	int newest = (valid[0] && (!valid[1] || slots[0].generation > slots[1].generation)) ? 0 : 1;
+	if (valid[newest] && (slots[newest].closed || SEGMENT_CHECK_RANGE(fd, &slots[newest]))){
+		good = slots[newest];
+	}
+	else if (valid[1 - newest]){
+		good = slots[1 - newest];		// Synced before the newer record was begun, no need to check
+	}
+
+	if (!good.closed){
+		if (ftruncate(fd, good.length) == 0 && fsync(fd) == 0){
+			good.closed = 1;
+			good.generation++;
+			SEGMENT_WRITE_COMMIT(commitFd, &good);
+		}
+	}
+	close(fd);
+	close(commitFd);
+	return (long long)good.length;
+}
+
+/* SEGMENT_COMMIT function
+	Makes everything appended so far durable. Returns 0, or -1 if
+	the card would not take it.
+*/
+static inline int SEGMENT_COMMIT (segment_writer *writer){
+	if (writer->fd < 0){return 0;}
+	writer->lastCommit = SAMPLE_NOW();
+	if (writer->length == writer->committed){return 0;}
+
+	long page = sysconf(_SC_PAGESIZE);
+	size_t start = writer->committed / page * page;
+	if (msync(writer->map + start, writer->length - start, MS_SYNC) != 0){return -1;}
+
+	segment_commit record;
+	memset(&record, 0, sizeof(record));
+	record.generation = writer->generation + 1;
+	record.length = writer->length;
+	record.previous = writer->committed;
+	record.crc = writer->crc;
+	if (SEGMENT_WRITE_COMMIT(writer->commitFd, &record) != 0){return -1;}
+	writer->generation = record.generation;
+	writer->committed = writer->length;
+	writer->crc = 0;
+	writer->commits++;
+	return 0;
+}
+
+/* SEGMENT_FINISH function
+	Commits, trims and closes the open segment.
+*/
+static inline int SEGMENT_FINISH (segment_writer *writer){
+	if (writer->fd < 0){return 0;}
+	int result = SEGMENT_COMMIT(writer);
+	munmap(writer->map, writer->capacity);
+	if (result == 0 && ftruncate(writer->fd, writer->committed) == 0 && fsync(writer->fd) == 0){
+		segment_commit record;
+		memset(&record, 0, sizeof(record));
+		record.closed = 1;
+		record.generation = writer->generation + 1;
+		record.length = record.previous = writer->committed;
+		result = SEGMENT_WRITE_COMMIT(writer->commitFd, &record);
+	}
+	else{result = -1;}
+	close(writer->fd);
+	close(writer->commitFd);
+	writer->fd = writer->commitFd = -1;
+	writer->map = NULL;
+	return result;
+}
+
+/* SEGMENT_ABANDON function
+	Closes and removes a segment SEGMENT_START could not finish
+	setting up, so nothing is left that looks like a closed one,
+	and schedules the next try under the same number.
+*/
+static inline int SEGMENT_ABANDON (segment_writer *writer){
+	char path[SEGMENT_PATH];
+	if (writer->map != NULL){munmap(writer->map, writer->capacity);}
+	if (writer->fd >= 0){close(writer->fd);}
+	if (writer->commitFd >= 0){close(writer->commitFd);}
+	SEGMENT_NAME(path, writer->prefix, writer->number, "lsm");
+	unlink(path);
+	SEGMENT_NAME(path, writer->prefix, writer->number, "commit");
+	unlink(path);
+	writer->number--;
+	writer->fd = writer->commitFd = -1;
+	writer->map = NULL;
+	writer->length = writer->committed = 0;
+	writer->crc = 0;
+	writer->generation = 0;
+	writer->failed = 1;
+	writer->failures++;
+	writer->retryAt = SAMPLE_NOW() + (long long)(writer->retryDelay * 1e9);
+	writer->retryDelay = writer->retryDelay * 2 < SEGMENT_RETRY_MAX ? writer->retryDelay * 2 : SEGMENT_RETRY_MAX;
+	return -1;
+}
+
+/* SEGMENT_START function
+	Creates, preallocates and maps the next segment. Returns 0, or
+	-1 with nothing of it left behind.
+*/
+static inline int SEGMENT_START (segment_writer *writer){
+	char path[SEGMENT_PATH];
+	writer->number++;
+	writer->map = NULL;
+	SEGMENT_NAME(path, writer->prefix, writer->number, "lsm");
+	writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	SEGMENT_NAME(path, writer->prefix, writer->number, "commit");
+	writer->commitFd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (writer->fd < 0 || writer->commitFd < 0){return SEGMENT_ABANDON(writer);}
+	if (posix_fallocate(writer->fd, 0, writer->capacity) != 0){return SEGMENT_ABANDON(writer);}	// Blocks reserved now, not on a fault later
+	void *map = mmap(NULL, writer->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd, 0);
+	if (map == MAP_FAILED){return SEGMENT_ABANDON(writer);}
+	writer->map = (unsigned char *)map;
+	writer->length = writer->committed = 0;
+	writer->crc = 0;
+	writer->generation = 0;
+
+	segment_commit record;											// Empty but valid from the start
+	memset(&record, 0, sizeof(record));
+	if (SEGMENT_WRITE_COMMIT(writer->commitFd, &record) != 0){return SEGMENT_ABANDON(writer);}
+	writer->opened = writer->lastCommit = SAMPLE_NOW();
+	writer->segments++;
+	writer->failed = 0;
+	writer->retryDelay = SEGMENT_RETRY;
+	return 0;
+}
+
+/* SEGMENT_OPEN function
+	Starts writing segments of capacity bytes under prefix, after
+	recovering and skipping any left by an earlier run. Returns 0,
+	or -1 if the first segment cannot be created.
+*/
+static inline int SEGMENT_OPEN (segment_writer *writer, const char *prefix, size_t capacity, double commitEvery, double rotateEvery){
+	memset(writer, 0, sizeof(*writer));
+	snprintf(writer->prefix, sizeof(writer->prefix), "%s", prefix);
+	writer->fd = writer->commitFd = -1;
+	writer->capacity = capacity;
+	writer->commitEvery = commitEvery;
+	writer->rotateEvery = rotateEvery;
+	writer->retryDelay = SEGMENT_RETRY;
+
+	char path[SEGMENT_PATH];
+	struct stat info;
+	for (writer->number = 0; ; writer->number++){					// Existing segments keep their numbers
+		SEGMENT_NAME(path, prefix, writer->number, "lsm");
+		if (stat(path, &info) != 0){break;}
+		segment_commit record;
+		SEGMENT_NAME(path, prefix, writer->number, "commit");
+		int fd = open(path, O_RDONLY);
+		int closed = fd >= 0 && ((SEGMENT_READ_COMMIT(fd, 0, &record) == 0 && record.closed) ||
+			(SEGMENT_READ_COMMIT(fd, 1, &record) == 0 && record.closed));
+		if (fd >= 0){close(fd);}
+		if (!closed && SEGMENT_RECOVER(prefix, writer->number) >= 0){writer->recovered++;}
+	}
+	writer->number--;
+	return SEGMENT_START(writer);
+}
+
+/* SEGMENT_APPEND function
+	Adds one encoded block, rotating and committing as due, and
+	retrying a failed start once its back-off has passed. Returns
+	0, or -1 if the block could not be stored or the card refused
+	a commit or close.
+*/
+static inline int SEGMENT_APPEND (segment_writer *writer, const unsigned char *block, size_t size){
+	if (size > writer->capacity){return -1;}
+	long long now = SAMPLE_NOW();
+	if (writer->fd < 0){
+		if (!writer->failed || now < writer->retryAt || SEGMENT_START(writer) != 0){
+			writer->lost++;
+			return -1;
+		}
+	}
+	int result = 0;
+	if (writer->length + size > writer->capacity ||
+		(writer->rotateEvery > 0 && now - writer->opened >= writer->rotateEvery * 1e9)){
+		if (SEGMENT_FINISH(writer) != 0){result = -1;}				// Its tail is lost, still start the next
+		if (SEGMENT_START(writer) != 0){
+			writer->lost++;
+			return -1;
+		}
+	}
+	memcpy(writer->map + writer->length, block, size);
+	writer->crc = SEGMENT_CRC(writer->crc, block, size);
+	writer->length += size;
+	if (writer->commitEvery > 0 && now - writer->lastCommit >= writer->commitEvery * 1e9){
+		if (SEGMENT_COMMIT(writer) != 0){result = -1;}
+	}
+	return result;
+}
+
+/* SEGMENT_CLOSE function
+	Finishes the open segment; the writer is done after this.
+*/
+static inline int SEGMENT_CLOSE (segment_writer *writer){
+	writer->failed = 0;											// No more retries
+	return SEGMENT_FINISH(writer);
+}
+
+#endif /* SEGMENTWRITER_H_ */
@@ -0,0 +1,407 @@
+/* Simulated LSM303 Header File
+
+	A userspace stand-in for the LSM303 accelerometer on an I2C
+	bus, so that every acquisition path can be run, benchmarked and
+	regression-tested on a plain Linux box without a BeagleBone.
+	It takes the place of an I2CTransport and models:
+
+		register map	auto-increment (sub-address bit 7) on the
+						accelerometer, always-increment on the
+						magnetometer, read-only status registers
+		ODR timing		samples are latched at the rate set in
+						CTRL_REG1_A, against the real clock or a
+						manual one for reproducible tests, with an
+						optional oscillator error in ppm
+		status			ZYXDA is cleared by reading OUT_Z_H_A and
+						ZYXOR is set when a sample is overwritten
+		FIFO			32 levels, bypass/FIFO/stream as set in
+						FIFO_CTRL_REG_A, watermark, overrun and
+						empty flags in FIFO_SRC_REG_A; no interrupt
+						is modelled, so trigger mode runs as stream
+		bus latency		a fixed cost per transaction plus nine
+						clocks per byte at a chosen bus speed
+		motion			still, vibration, rotation or noise
+
+	Devices: accelerometer at its address (0x19 by default) and the
+	magnetometer at 0x1E, which only supplies the temperature: 12
+	bits at 8 LSB per degree C in TEMP_OUT_H_M/L_M, reading 0 until
+	TEMP_EN is set in CRA_REG_M.
+*/
+
+#ifndef SIMULATEDLSM303_H_
+#define SIMULATEDLSM303_H_
+
+#include "I2CTransport.h"
+#include "LSM303Profile.h"
+
+#include <math.h>
+#include <time.h>
+
+#define SIM_MAG_ADDRESS		0x1E	// Magnetometer, temperature only
+#define SIM_REGISTERS		0x80	// Size of each register map
+#define SIM_FIFO_DEPTH		32		// LSM303 FIFO levels
+#define SIM_STATUS_REG_A	0x27	// ZYXOR .. ZYXDA
+#define SIM_OUT_X_L_A		0x28	// First data register
+#define SIM_OUT_Z_H_A		0x2D	// Last data register, reading it completes a sample
+#define SIM_FIFO_SRC_REG_A	0x2F	// WTM OVRN EMPTY FSS[4:0]
+#define SIM_CRA_REG_M		0x00	// TEMP_EN DO[2:0]
+#define SIM_MR_REG_M		0x02	// Last writable magnetometer register
+#define SIM_TEMP_OUT_H_M	0x31	// Magnetometer temperature, high byte
+#define SIM_TEMP_OUT_L_M	0x32	// ... low nibble in bits 7:4
+#define SIM_TEMP_EN			0x80	// CRA_REG_M, temperature sensor on
+
+/* SIM_MOTION enumeration
+	Synthetic motion applied to the simulated sensor.
+*/
+enum SIM_MOTION {
+	SIM_STILL		= 0,	// Gravity on Z only
+	SIM_VIBRATION	= 1,	// Gravity plus a sine of amplitude g on X
+	SIM_ROTATION	= 2,	// Gravity turning around X at frequency Hz
+	SIM_NOISE		= 3		// Gravity plus uniform noise of amplitude g
+};
+
+/* SimulatedLSM303 class definition
+*/
+class SimulatedLSM303 : public I2CTransport {
+
+	private:
+		struct Frame { short x, y, z; };
+
+		unsigned char accel[SIM_REGISTERS];		// Accelerometer register map
+		unsigned char mag[SIM_REGISTERS];		// Magnetometer register map
+		int  pointerDevice;						// Device the register pointer belongs to
+		int  pointer;							// Current register
+		bool increment;							// Auto-increment for the current access
+
+		Frame fifo[SIM_FIFO_DEPTH];				// Oldest first
+		int  fifoCount;
+		bool fifoOverrun;
+
+		bool manualClock;						// Time only moves on advanceClock()
+		long long manualNow;
+		long long enabledAt;					// When the current ODR took effect
+		long long latched;						// Samples latched since enabledAt
+		double clockScale;						// Actual over nominal ODR
+
+		long long perTransaction;				// Bus cost in nanoseconds
+		int  busHz;								// Bus clock, 0 for no per-byte cost
+
+		int  motion;							// SIM_MOTION
+		double amplitude, frequency;
+		unsigned int noiseState;				// Deterministic noise
+
+		unsigned long transactions;				// Statistics
+		unsigned long bytes;
+		unsigned long samples;
+
+		long long now();
+		double odr();							// Current output data rate in Hz
+		bool fifoEnabled();
+		int  fifoMode();
+		void catchUp();							// Latches every sample due by now
+		void latch(long long index);			// Generates sample index
+		void showHead();						// Copies the FIFO head into OUT_*
+		unsigned char peek(int device, int reg);
+		void poke(int device, int reg, unsigned char value);
+		void busDelay(int length);
+		int  access(int device, bool read, unsigned char *buffer, int length);
+
+	public:
+		SimulatedLSM303(int address = 0x19);
+
+		void setBusTiming(long long transactionNanoseconds, int hz);	// 0, 0 is instantaneous
+		void setMotion(int kind, double amplitudeG = 0.5, double frequencyHz = 1.0);
+		void useManualClock(bool manual);
+		void advanceClock(long long nanoseconds);
+		void setClockError(double ppm) { clockScale = 1.0 + ppm * 1e-6; }	// Positive runs fast, before setting the ODR
+
+		unsigned long getTransactions() { return transactions; }
+		unsigned long getBytes() { return bytes; }
+		unsigned long getSamples() { return samples; }
+
+		// I2CTransport
+		int  reopen() { return 0; }
+		void closeDevice() {}
+		bool isOpen() { return true; }
+		int  writeBytes(const char *buffer, int length);
+		int  readBytes(char *buffer, int length);
+		int  transfer(struct i2c_msg *messages, int count);
+};
+
+SimulatedLSM303::SimulatedLSM303(int address)
+	: I2CTransport(address, "simulated LSM303") {
+	memset(accel, 0, sizeof(accel));
+	memset(mag, 0, sizeof(mag));
+	accel[CTRL_REG1_A] = 0x07;					// Power-on default, table 19
+	mag[SIM_CRA_REG_M] = 0x10;					// Power-on default, 15 Hz, TEMP_EN clear
+	mag[SIM_TEMP_OUT_H_M] = 0x0C;				// 25 C, 200 << 4
+	mag[SIM_TEMP_OUT_L_M] = 0x80;
+	accel[SIM_FIFO_SRC_REG_A] = 0x20;			// EMPTY
+	pointerDevice = address;
+	pointer = 0;
+	increment = false;
+	fifoCount = 0;
+	fifoOverrun = false;
+	manualClock = false;
+	manualNow = 0;
+	clockScale = 1.0;
+	latched = 0;
+	perTransaction = 0;
+	busHz = 0;
+	motion = SIM_STILL;
+	amplitude = 0.5;
+	frequency = 1.0;
+	noiseState = 12345;
+	transactions = 0;
+	bytes = 0;
+	samples = 0;
+	enabledAt = now();
+}
+
+void SimulatedLSM303::setBusTiming(long long transactionNanoseconds, int hz){
+	perTransaction = transactionNanoseconds;
+	busHz = hz;
+}
+
+void SimulatedLSM303::setMotion(int kind, double amplitudeG, double frequencyHz){
+	motion = kind;
+	amplitude = amplitudeG;
+	frequency = frequencyHz;
+}
+
+void SimulatedLSM303::useManualClock(bool manual){
+	manualClock = manual;
+	manualNow = 0;
+	enabledAt = 0;
+	latched = 0;
+}
+
+void SimulatedLSM303::advanceClock(long long nanoseconds){
+	manualNow += nanoseconds;
+}
+
+long long SimulatedLSM303::now(){
+	if (manualClock){return manualNow;}
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* odr function
+	ODR[3:0] of CTRL_REG1_A in Hz, table 20, off by the oscillator
+	error set with setClockError().
+*/
+double SimulatedLSM303::odr(){
+	return PROFILE_ODR_HZ(accel[CTRL_REG1_A]) * clockScale;
+}
+
+bool SimulatedLSM303::fifoEnabled(){
+	return (accel[CTRL_REG5_A] & 0x40) && fifoMode() != PROFILE_FIFO_BYPASS;
+}
+
+int SimulatedLSM303::fifoMode(){
+	return accel[FIFO_CTRL_REG_A] >> 6;
+}
+
+/* latch function
+	Computes the motion at the time of sample index and either
+	writes it to OUT_* (bypass) or appends it to the FIFO.
+*/
+void SimulatedLSM303::latch(long long index){
+	double t = index / odr();
+	double w = 2 * M_PI * frequency * t;
+	double x = 0, y = 0, z = 1;					// g
+	switch(motion){
+		case SIM_VIBRATION:
+			x = amplitude * sin(w);
+			break;
+		case SIM_ROTATION:
+			y = sin(w);
+			z = cos(w);
+			break;
+		case SIM_NOISE:
+			noiseState = noiseState * 1103515245 + 12345;
+			x = amplitude * (((noiseState >> 16) & 0x7FFF) / 16383.5 - 1);
+			noiseState = noiseState * 1103515245 + 12345;
+			y = amplitude * (((noiseState >> 16) & 0x7FFF) / 16383.5 - 1);
+			break;
+		default:
+			break;
+	}
+
+	int fs = (accel[CTRL_REG4_A] >> 4) & 0x03;	// 2, 4, 8, 16 g
+	double scale = 32768.0 / (2 << fs);			// Left-justified counts per g
+	Frame f;
+	f.x = (short)fmax(-32768, fmin(32767, x * scale));
+	f.y = (short)fmax(-32768, fmin(32767, y * scale));
+	f.z = (short)fmax(-32768, fmin(32767, z * scale));
+	samples++;
+
+	if (fifoEnabled()){
+		if (fifoCount == SIM_FIFO_DEPTH){
+			fifoOverrun = true;
+			if (fifoMode() == PROFILE_FIFO_FIFO){return;}	// FIFO mode stops when full
+			memmove(fifo, fifo + 1, sizeof(Frame) * (SIM_FIFO_DEPTH - 1));	// Stream and trigger drop the oldest
+			fifoCount--;
+		}
+		fifo[fifoCount++] = f;
+		if (fifoCount == 1){showHead();}
+		return;
+	}
+
+	if (accel[SIM_STATUS_REG_A] & 0x08){accel[SIM_STATUS_REG_A] |= 0xF0;}	// Previous sample never read
+	accel[SIM_STATUS_REG_A] |= 0x0F;
+	accel[SIM_OUT_X_L_A + 0] = f.x & 0xFF;	accel[SIM_OUT_X_L_A + 1] = (f.x >> 8) & 0xFF;
+	accel[SIM_OUT_X_L_A + 2] = f.y & 0xFF;	accel[SIM_OUT_X_L_A + 3] = (f.y >> 8) & 0xFF;
+	accel[SIM_OUT_X_L_A + 4] = f.z & 0xFF;	accel[SIM_OUT_X_L_A + 5] = (f.z >> 8) & 0xFF;
+}
+
+void SimulatedLSM303::showHead(){
+	const Frame &f = fifo[0];
+	accel[SIM_OUT_X_L_A + 0] = f.x & 0xFF;	accel[SIM_OUT_X_L_A + 1] = (f.x >> 8) & 0xFF;
+	accel[SIM_OUT_X_L_A + 2] = f.y & 0xFF;	accel[SIM_OUT_X_L_A + 3] = (f.y >> 8) & 0xFF;
+	accel[SIM_OUT_X_L_A + 4] = f.z & 0xFF;	accel[SIM_OUT_X_L_A + 5] = (f.z >> 8) & 0xFF;
+}
+
+/* catchUp function
+	Latches every sample whose time has come. At most one FIFO
+	worth is generated per call, older ones would be lost anyway.
+*/
+void SimulatedLSM303::catchUp(){
+	double rate = odr();
+	if (rate == 0){return;}
+	long long due = (long long)((now() - enabledAt) * rate / 1e9);
+	if (due - latched > SIM_FIFO_DEPTH + 1){
+		if (!fifoEnabled() && (accel[SIM_STATUS_REG_A] & 0x08)){accel[SIM_STATUS_REG_A] |= 0xF0;}
+		if (fifoEnabled() && fifoCount + (due - latched) > SIM_FIFO_DEPTH){fifoOverrun = true;}
+		latched = due - SIM_FIFO_DEPTH - 1;
+	}
+	while (latched < due){latch(++latched);}
+
+	unsigned char src = fifoCount >= SIM_FIFO_DEPTH ? SIM_FIFO_DEPTH - 1 : fifoCount;
+	if (fifoCount == 0){src |= 0x20;}
+	if (fifoOverrun){src |= 0x40;}
+	if (fifoCount > (accel[FIFO_CTRL_REG_A] & 0x1F)){src |= 0x80;}
+	accel[SIM_FIFO_SRC_REG_A] = src;
+	if (fifoEnabled()){accel[SIM_STATUS_REG_A] = fifoCount ? 0x0F : 0x00;}
+}
+
+unsigned char SimulatedLSM303::peek(int device, int reg){
+	if (device == SIM_MAG_ADDRESS){
+		reg &= 0x7F;
+		if ((reg == SIM_TEMP_OUT_H_M || reg == SIM_TEMP_OUT_L_M) && !(mag[SIM_CRA_REG_M] & SIM_TEMP_EN)){return 0;}	// Sensor off
+		return mag[reg];
+	}
+
+	unsigned char value = accel[reg & 0x7F];
+	if (reg == SIM_OUT_Z_H_A){					// Sample fully read
+		if (fifoEnabled()){
+			if (fifoCount > 0){
+				memmove(fifo, fifo + 1, sizeof(Frame) * (fifoCount - 1));
+				fifoCount--;
+				fifoOverrun = false;
+				if (fifoCount > 0){showHead();}
+			}
+		}
+		else{
+			accel[SIM_STATUS_REG_A] = 0x00;		// Clears ZYXDA and ZYXOR
+		}
+	}
+	return value;
+}
+
+/* poke function
+	Read-only registers ignore writes. Writing CTRL_REG1_A restarts
+	the sample clock, switching to bypass empties the FIFO.
+*/
+void SimulatedLSM303::poke(int device, int reg, unsigned char value){
+	reg &= 0x7F;
+	if (device == SIM_MAG_ADDRESS){
+		if (reg <= SIM_MR_REG_M){mag[reg] = value;}	// CRA_REG_M, CRB_REG_M, MR_REG_M
+		return;
+	}
+	if (reg == SIM_STATUS_REG_A || (reg >= SIM_OUT_X_L_A && reg <= SIM_FIFO_SRC_REG_A && reg != FIFO_CTRL_REG_A)){
+		return;
+	}
+	accel[reg] = value;
+	if (reg == CTRL_REG1_A){
+		enabledAt = now();
+		latched = 0;
+	}
+	if ((reg == FIFO_CTRL_REG_A || reg == CTRL_REG5_A) && !fifoEnabled()){
+		fifoCount = 0;
+		fifoOverrun = false;
+	}
+}
+
+/* busDelay function
+	Spins for the bus time of one transaction of length bytes, so
+	the caller's thread is busy for as long as a real transfer.
+*/
+void SimulatedLSM303::busDelay(int length){
+	long long cost = perTransaction;
+	if (busHz > 0){cost += (long long)(length + 2) * 9 * 1000000000LL / busHz;}
+	if (cost <= 0){return;}
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	long long until = (long long)t.tv_sec * 1000000000LL + t.tv_nsec + cost;
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &t);
+	} while ((long long)t.tv_sec * 1000000000LL + t.tv_nsec < until);
+}
+
+/* access function
+	One message. A write sets the register pointer from its first
+	byte and stores the rest; a read returns bytes from the pointer.
+	Unknown devices do not acknowledge.
+*/
+int SimulatedLSM303::access(int device, bool read, unsigned char *buffer, int length){
+	if (device != I2CAddress && device != SIM_MAG_ADDRESS){return -1;}
+	catchUp();
+	if (!read){
+		if (length < 1){return -1;}
+		pointerDevice = device;
+		pointer = buffer[0] & 0x7F;
+		increment = (device == SIM_MAG_ADDRESS) || (buffer[0] & 0x80);
+		for (int i = 1; i < length; i++){
+			poke(device, pointer, buffer[i]);
+			if (increment){pointer = (pointer + 1) & 0x7F;}
+		}
+	}
+	else{
+		if (device != pointerDevice){pointer = 0;}
+		for (int i = 0; i < length; i++){
+			buffer[i] = peek(device, pointer);
+			if (increment){pointer = (pointer + 1) & 0x7F;}
+		}
+	}
+	bytes += length;
+	return length;
+}
+
+int SimulatedLSM303::writeBytes(const char *buffer, int length){
+	transactions++;
+	busDelay(length);
+	return access(I2CAddress, false, (unsigned char *)buffer, length) == length ? 0 : 3;
+}
+
+int SimulatedLSM303::readBytes(char *buffer, int length){
+	transactions++;
+	busDelay(length);
+	return access(I2CAddress, true, (unsigned char *)buffer, length);
+}
+
+int SimulatedLSM303::transfer(struct i2c_msg *messages, int count){
+	transactions++;
+	int length = 0;
+	for (int i = 0; i < count; i++){length += messages[i].len;}
+	busDelay(length + count - 1);				// Repeated starts resend the address
+	for (int i = 0; i < count; i++){
+		if (access(messages[i].addr, messages[i].flags & I2C_M_RD, messages[i].buf, messages[i].len) < 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+#endif /* SIMULATEDLSM303_H_ */
@@ -0,0 +1,243 @@
+/* Trace Recorder Header File
+
+	A flight recorder for the sampling loop. Every thread that
+	records gets its own ring of fixed-size events (begin, end,
+	instant) with CLOCK_MONOTONIC nanosecond timestamps. Only the
+	owning thread writes its ring, so recording takes no lock and
+	never allocates after the ring exists; the oldest events are
+	overwritten when it is full.
+
+		TRACE_SCOPE("decode");				// begin now, end at the closing brace
+		TRACE_BEGIN("flush"); ... TRACE_END("flush");
+		TRACE_INSTANT("bus cycle", count);
+
+	Names must be string literals (only the pointer is stored).
+
+	Recording is off until traceRecorder().setEnabled(true); while
+	off each macro costs one relaxed load and a branch. Building with
+	-DTRACE_DISABLED removes the macros entirely.
+
+	exportChrome() writes the rings as Chrome trace JSON, which
+	chrome://tracing and ui.perfetto.dev both open. A dump can also
+	be requested from outside with the signal given to watchSignal()
+	(SIGUSR2 by default); the next pollSignal() writes the file.
+
+	Needs -std=c++11.
+*/
+
+#ifndef TRACERECORDER_H_
+#define TRACERECORDER_H_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define TRACE_RING_EVENTS	16384	// Per thread, power of two
+#define TRACE_NAME_SIZE		16		// Thread name length, as pthread_setname_np
+#define TRACE_SAFETY		64		// Oldest events skipped on export of a wrapped ring
+
+/* TraceEvent structure
+	One record. phase follows the Chrome trace format: 'B' begin,
+	'E' end, 'i' instant.
+*/
+struct TraceEvent {
+	long long timestamp;					// CLOCK_MONOTONIC nanoseconds
+	const char *name;						// Literal, never copied
+	int arg;								// Free use, exported as args.value
+	char phase;
+};
+
+/* TraceRing class definition
+	Events of one thread. written only grows; the slot of event n
+	is n modulo the ring size.
+*/
+class TraceRing {
+
+	public:
+		TraceEvent events[TRACE_RING_EVENTS];
+		std::atomic<unsigned long long> written;
+		int tid;								// Kernel thread id
+		char name[TRACE_NAME_SIZE];				// Optional, see TraceRecorder::nameThread
+
+		TraceRing() : written(0), tid((int)syscall(SYS_gettid)) { name[0] = '\0'; }
+
+		void add(char phase, const char *label, int arg){
+			unsigned long long n = written.load(std::memory_order_relaxed);
+			TraceEvent &e = events[n & (TRACE_RING_EVENTS - 1)];
+			struct timespec t;
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			e.timestamp = (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+			e.name = label;
+			e.arg = arg;
+			e.phase = phase;
+			written.store(n + 1, std::memory_order_release);
+		}
+};
+
+/* TraceRecorder class definition
+	Owns every ring ever created, so threads that have exited still
+	show in a dump. The lock is only taken when a thread records for
+	the first time and while exporting.
+*/
+class TraceRecorder {
+
+	private:
+		std::atomic<bool> enabled;
+		std::mutex lock;						// Guards rings
+		std::vector<TraceRing*> rings;
+
+		static volatile sig_atomic_t requested;	// Set by the signal handler
+		static void onSignal(int) { requested = 1; }
+
+		TraceRecorder(const TraceRecorder&);				// Not copyable
+		TraceRecorder& operator=(const TraceRecorder&);	// ...
+
+	public:
+		TraceRecorder() : enabled(false) {}
+		~TraceRecorder() { for (size_t i = 0; i < rings.size(); i++){delete rings[i];} }
+
+		bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+		void setEnabled(bool on) { enabled = on; }
+
+		TraceRing *ring();						// The calling thread's, created on first use
+		void record(char phase, const char *name, int arg = 0) { ring()->add(phase, name, arg); }
+		void nameThread(const char *name);		// Label for the calling thread in the viewer
+
+		int  exportChrome(FILE *out);			// Returns events written
+		int  exportChrome(const char *filename);
+		void watchSignal(int signal = SIGUSR2);	// Dump on the next pollSignal() after signal
+		bool pollSignal(const char *filename);	// Returns true if it wrote the file
+};
+
+volatile sig_atomic_t TraceRecorder::requested = 0;
+
+TraceRing *TraceRecorder::ring(){
+	static thread_local TraceRing *mine = NULL;
+	if (mine == NULL){
+		mine = new TraceRing();
+		std::lock_guard<std::mutex> guard(lock);
+		rings.push_back(mine);
+	}
+	return mine;
+}
+
+void TraceRecorder::nameThread(const char *name){
+	TraceRing *r = ring();
+	snprintf(r->name, sizeof(r->name), "%s", name);
+}
+
+/* exportChrome function
+	Writes one JSON object per event, per thread in recording
+	order. Ends without a matching begin (the begin was overwritten)
+	are left out so the viewer does not nest them wrongly.
+*/
+int TraceRecorder::exportChrome(FILE *out){
+	std::lock_guard<std::mutex> guard(lock);
+	int pid = (int)getpid();
+	int count = 0;
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (size_t r = 0; r < rings.size(); r++){
+		TraceRing *ring = rings[r];
+		if (ring->name[0] != '\0'){
+			fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				count ? ",\n" : "", pid, ring->tid, ring->name);
+			count++;
+		}
+		unsigned long long end = ring->written.load(std::memory_order_acquire);
+		unsigned long long start = 0;
+		if (end > TRACE_RING_EVENTS){start = end - TRACE_RING_EVENTS + TRACE_SAFETY;}	// Writer may be overwriting the oldest
+		int depth = 0;
+		for (unsigned long long n = start; n < end; n++){
+			TraceEvent e = ring->events[n & (TRACE_RING_EVENTS - 1)];
+			if (e.phase == 'E'){
+				if (depth == 0){continue;}
+				depth--;
+			}
+			else if (e.phase == 'B'){depth++;}
+			fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld.%03lld,\"pid\":%d,\"tid\":%d%s",
+				count ? ",\n" : "", e.name, e.phase, e.timestamp / 1000, e.timestamp % 1000, pid, ring->tid,
+				e.phase == 'i' ? ",\"s\":\"t\"" : "");
+			if (e.arg != 0){fprintf(out, ",\"args\":{\"value\":%d}", e.arg);}
+			fprintf(out, "}");
+			count++;
+		}
+	}
+	fprintf(out, "\n]}\n");
+	return count;
+}
+
+int TraceRecorder::exportChrome(const char *filename){
+	FILE *fpOUT = fopen(filename, "w");
+	if (fpOUT == NULL){
+		fprintf(stderr, "Error: Trouble opening %s file.\n", filename);
+		return -1;
+	}
+	int count = exportChrome(fpOUT);
+	fclose(fpOUT);
+	return count;
+}
+
+void TraceRecorder::watchSignal(int signal){
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = onSignal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(signal, &action, NULL);
+}
+
+bool TraceRecorder::pollSignal(const char *filename){
+	if (!requested){return false;}
+	requested = 0;
+	exportChrome(filename);
+	return true;
+}
+
+/* traceRecorder function
+	The process-wide recorder the macros write to.
+*/
+inline TraceRecorder &traceRecorder(){
+	static TraceRecorder recorder;
+	return recorder;
+}
+
+/* TraceScope class definition
+	Begin on construction, end on destruction, only if recording
+	was on at the beginning.
+*/
+class TraceScope {
+
+	private:
+		const char *name;						// NULL when not recording
+
+	public:
+		explicit TraceScope(const char *label) : name(NULL) {
+			if (traceRecorder().isEnabled()){
+				name = label;
+				traceRecorder().record('B', label);
+			}
+		}
+		~TraceScope() { if (name){traceRecorder().record('E', name);} }
+};
+
+#ifdef TRACE_DISABLED
+#define TRACE_BEGIN(name)			do {} while (0)
+#define TRACE_END(name)				do {} while (0)
+#define TRACE_INSTANT(name, arg)	do {} while (0)
+#define TRACE_SCOPE(name)			do {} while (0)
+#else
+#define TRACE_CONCAT_(a, b)			a##b
+#define TRACE_CONCAT(a, b)			TRACE_CONCAT_(a, b)
+#define TRACE_BEGIN(name)			do { if (traceRecorder().isEnabled()){traceRecorder().record('B', name);} } while (0)
+#define TRACE_END(name)				do { if (traceRecorder().isEnabled()){traceRecorder().record('E', name);} } while (0)
+#define TRACE_INSTANT(name, arg)	do { if (traceRecorder().isEnabled()){traceRecorder().record('i', name, arg);} } while (0)
+#define TRACE_SCOPE(name)			TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#endif
+
+#endif /* TRACERECORDER_H_ */
@@ -0,0 +1,36 @@
+/* Multi-Rate Acquisition
+	
+	Samples every sensor of the 10-DOF board on one I2C bus at its
+	own rate through the BusScheduler, then prints the bus
+	utilization and the deadline misses of each device.
+	
+		accelerometer	0x19	400 Hz	OUT_X_L_A..OUT_Z_H_A
+		magnetometer	0x1E	75 Hz	OUT_X_H_M..OUT_Y_L_M
+		barometer		0x77	10 Hz	BMP180 result, next conversion started
+		temperature		0x1E	1 Hz	TEMP_OUT_H_M, TEMP_OUT_L_M
+	
+	Build:	g++ -std=c++11 -O2 -IIncludes MULTIRATE.cpp -o MULTIRATE
+	Usage:	MULTIRATE [seconds] [bus]
+*/
+
+#include "BusScheduler.h"
+#include <stdlib.h>
+
+int main (int argc, char *argv[]){
+	double seconds = (argc > 1) ? atof(argv[1]) : 10;	// Run time
+	int bus = (argc > 2) ? atoi(argv[2]) : 1;			// Bus the board is on
+	
+	BusScheduler scheduler(bus);
+	
+	// Higher priority is issued first within a cycle
+	scheduler.addJob("accelerometer", 0x19, 0x28 | 0x80, 6, 400, 3);	// Auto-increment burst
+	scheduler.addJob("magnetometer", 0x1E, 0x03, 6, 75, 2);			// Increments on its own
+	int baro = scheduler.addJob("barometer", 0x77, 0xF6, 3, 10, 1);	// MSB, LSB, XLSB
+	scheduler.setCommand(baro, 0xF4, 0x34);								// Start the next pressure conversion
+	scheduler.addJob("temperature", 0x1E, 0x31, 2, 1, 0);				// TEMP_OUT_H_M, TEMP_OUT_L_M
+	
+	scheduler.run(seconds);
+	scheduler.report(stdout);
+	
+	return 0;	// TERMINATE MAIN PROGRAM
+}
@@ -0,0 +1,63 @@
+/* Capture Query
+
+	Answers "what happened between t1 and t2" from a compressed
+	capture (SESSIONS -compress) using the block summaries of
+	CaptureIndex.h, without decoding more than the blocks at the
+	ends of the range. from and to are seconds after the first
+	sample, the whole capture without them.
+
+	Counts are the driver's, the raw register pair shifted right by
+	two, as in Resampled-<bus>-<address>.txt.
+
+	Build:	gcc -O2 -IIncludes QUERY.c -o QUERY -lm
+	Usage:	QUERY capture [from to]
+	e.g.	QUERY Capture-2-0x19.lsm 12.5 13
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "Includes/CaptureIndex.h"
+#include "Includes/SampleClock.h"
+
+int main (int argc, char *argv[]){
+	if (argc != 2 && argc != 4){
+		printf("Error: Expected a capture file and optionally from and to seconds.\n");	// Inform the user of the error
+		exit(1);																	// Exit with error
+	}
+
+	capture_index index;
+	if (INDEX_OPEN(&index, argv[1]) <= 0){
+		printf("Error: %s is not a compressed capture.\n", argv[1]);
+		exit(1);
+	}
+	int64_t start = index.zones[0].summary.low;
+	for (size_t z = 1; z < index.count; z++){
+		if (index.zones[z].summary.low < start){start = index.zones[z].summary.low;}
+	}
+	int64_t from = (argc == 4) ? start + (int64_t)(atof(argv[2]) * 1e9) : INT64_MIN;
+	int64_t to = (argc == 4) ? start + (int64_t)(atof(argv[3]) * 1e9) : INT64_MAX;
+
+	capture_range range;
+	long long began = SAMPLE_NOW();
+	long long found = INDEX_QUERY(&index, from, to, &range);
+	long long took = SAMPLE_NOW() - began;
+	if (found < 0){
+		printf("Error: %s is damaged.\n", argv[1]);
+		exit(1);
+	}
+
+	printf("%lld of %llu samples\t%zu blocks, %zu decoded\t%.1f us\n", found, index.samples, index.count, index.decoded, took / 1e3);
+	if (found > 0){
+		printf("from %.6f to %.6f s\n", (range.first - start) / 1e9, (range.last - start) / 1e9);
+		const char *names[3] = {"x", "y", "z"};
+		printf("axis\tmin\tmax\tmean\n");
+		for (int a = 0; a < 3; a++){
+			printf("%s\t%d\t%d\t%.2f\n", names[a], range.min[a] >> 2, range.max[a] >> 2, range.sum[a] / 4.0 / found);
+		}
+		printf("peak\t%.1f\n", sqrt((double)range.peak) / 4);	// Largest magnitude
+	}
+
+	INDEX_CLOSE(&index);
+	return 0;	// TERMINATE MAIN PROGRAM
+}
@@ -0,0 +1,71 @@
+/* Capture Replay
+
+	Plays a PrettyData capture back through an AcquisitionSession,
+	the same path SESSIONS drains during live acquisition, and
+	writes what comes out in the same format. Useful to check that
+	the pipeline reproduces a capture byte for byte, and to measure
+	processing throughput without the bus.
+
+	speed is 1 for real time, N for N times faster and 0 for as
+	fast as possible. rate is the rate the capture was taken at.
+	A compressed capture (SESSIONS -compress) works the same way and
+	is written back out as PrettyData.
+
+	Build:	g++ -std=c++11 -O2 -pthread -IIncludes REPLAY.cpp -o REPLAY
+	Usage:	REPLAY capture rate [speed] [output]
+	e.g.	REPLAY PrettyData.txt 400 0 Replayed.txt
+*/
+
+#include "CaptureReplay.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+#define DRAIN_BATCH 256		// Samples taken from the session per pass
+
+int main (int argc, char *argv[]){
+	if (argc < 3){
+		printf("Error: Expected a capture file and its rate.\n");	// Inform the user of the error
+		exit(1);													// Exit with error
+	}
+	double rate = atof(argv[2]);
+	double speed = (argc > 3) ? atof(argv[3]) : 1.0;
+	const char *filename = (argc > 4) ? argv[4] : "Replayed.txt";
+
+	CaptureReplay replay(rate, speed);
+	if (replay.load(argv[1]) <= 0){
+		printf("Error: No samples in %s.\n", argv[1]);
+		exit(1);
+	}
+
+	FILE *fpOUT = fopen(filename, "w");
+	if (fpOUT == NULL){
+		printf("Error: Trouble opening %s file.\n", filename);
+		exit(1);
+	}
+
+	AcquisitionSession session(-1, 0x19, rate);
+	replay.start(&session);
+
+	RawSample batch[DRAIN_BATCH];
+	while (true){
+		bool done = replay.isFinished();					// Checked before draining
+		size_t n = session.pop(batch, DRAIN_BATCH);
+		if (n == 0 && done){break;}							// Nothing can arrive any more
+		for (size_t i = 0; i < n; i++){
+			fprintf(fpOUT, "%u\t0x%x 0x%x 0x%x 0x%x 0x%x 0x%x\n",	// Same layout as PDUMP
+				batch[i].sequence,
+				batch[i].data[0], batch[i].data[1],
+				batch[i].data[2], batch[i].data[3],
+				batch[i].data[4], batch[i].data[5]);
+		}
+		if (n == 0){usleep(speed > 0 ? 10000 : 100);}
+	}
+	replay.wait();
+	fclose(fpOUT);
+
+	printf("%lu samples in %.3f s, %.1f samples/sec, %.2fx capture speed, %lu dropped\n",
+		replay.getFed(), replay.getElapsed(), replay.getFed() / replay.getElapsed(),
+		replay.getAchievedSpeed(), session.getDropped());
+
+	return 0;	// TERMINATE MAIN PROGRAM
+}
@@ -0,0 +1,309 @@
+/* Multi-Sensor Acquisition
+	
+	Samples any number of accelerometers, on any of the buses, in
+	one process. Each sensor is an AcquisitionSession and every bus
+	gets its own worker thread, so sensors on different buses are
+	read in parallel. The samples of each sensor are written in the
+	PrettyData.txt format of READ.c to PrettyData-<bus>-<address>.txt.
+	The fitted sample times (SampleClock.h) go next to them, one
+	"<sequence>	<CLOCK_MONOTONIC_RAW ns>" line per sample, in
+	Timestamps-<bus>-<address>.txt. odr is the rate the sensor was
+	set to, if it is not the read rate.
+	
+	With -compress both go instead into one CaptureCodec.h capture,
+	Capture-<bus>-<address>.lsm, a few bytes per sample. REPLAY and
+	PIPELINE take it in place of a PrettyData file, QUERY answers
+	time range questions from it.
+	
+	-rolling mb[:seconds] compresses the same way but into
+	SegmentWriter.h segments, Capture-<bus>-<address>-<n>.lsm, of mb
+	megabytes or seconds each, committed to the card every
+	ROLLING_COMMIT seconds so a power cut loses no more than that.
+	Segments left open by a crash are recovered at the next start.
+	
+	With -resample hz every sensor is also put on a uniform hz grid
+	with the windowed sinc of Resampler.h, one "<grid ns>	<x> <y>
+	<z>" line per point in raw counts, in Resampled-<bus>-<address>.txt.
+	
+	Every file is written by its own CaptureWriter.h thread in large
+	page-aligned writes, so a stalled SD card holds up neither the
+	draining nor the bus workers until its buffers are all queued.
+	-rolling segments are appended, rotated and committed the same
+	way by a RollingWriter.h thread. The end of the run reports each
+	writer's throughput, queue depth and stalls.
+	
+	With -keep mb the samples of every sensor are also held in RAM
+	in a SampleStore.h store of up to mb megabytes, the newest kept,
+	and the end of the run reports how much of it they took.
+	
+	kill -USR1 <pid> prints the per-stage latency so far, the same
+	report is printed at the end.
+	
+	With -trace bus transfers, decodes, drains and scheduler cycles
+	are recorded, kill -USR2 <pid> writes them to Trace.json and so
+	does the end of the run. Open it in chrome://tracing or
+	ui.perfetto.dev.
+	
+	With -sim every bus is a SimulatedLSM303 with 100 kHz timing
+	and a 1344 Hz ODR that is SIM_CLOCK_PPM fast, so the scaling and
+	the clock fit can be checked without a sensor attached.
+	
+	Build:	g++ -std=c++11 -O2 -pthread -IIncludes SESSIONS.cpp -o SESSIONS
+	Usage:	SESSIONS [-sim] [-trace] [-compress] [-rolling mb[:seconds]] [-keep mb] [-resample hz] seconds bus:address[:rate[:odr]] ...
+	e.g.	SESSIONS 10 0:0x19:400 1:0x19:400 2:0x19:400
+			SESSIONS -sim 10 0:0x19:1500
+*/
+
+#include "AcquisitionSession.h"
+#include "CaptureCodec.h"
+#include "CaptureWriter.h"
+#include "Resampler.h"
+#include "RollingWriter.h"
+#include "SampleStore.h"
+#include "SimulatedLSM303.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+#define DRAIN_BATCH 256		// Samples taken from a session per pass
+#define TRACE_FILE "Trace.json"
+#define SIM_CLOCK_PPM 1500	// Oscillator error of the simulated sensors
+#define ROLLING_COMMIT 1.0	// Seconds between commits of -rolling segments
+#define OUTPUT_LINE 80		// Longest text line written
+
+/* output structure
+	Where one session's samples go.
+*/
+struct output{
+	CaptureWriter *pretty;	// PrettyData-<bus>-<address>.txt, NULL with -compress
+	CaptureWriter *times;	// Timestamps-<bus>-<address>.txt, ...
+	CaptureWriter *capture;	// Capture-<bus>-<address>.lsm, NULL without -compress
+	RollingWriter *segments;	// Capture-<bus>-<address>-<n>.lsm, NULL without -rolling
+	codec_sample *block;	// Samples not yet encoded, CODEC_BLOCK
+	int pending;			// ...
+	sample_store *store;	// NULL without -keep
+	CaptureWriter *grid;	// Resampled-<bus>-<address>.txt, NULL without -resample
+	Resampler *resampler;	// ...
+};
+typedef struct output output;	// Define type for output
+
+/* ENCODE function
+	Writes the pending samples of a compressed output as one block.
+*/
+void ENCODE (output *out){
+	if (out->pending == 0){return;}
+	unsigned char block[CODEC_MAX_BLOCK];
+	size_t size = CODEC_ENCODE(out->block, out->pending, block);
+	if (out->segments != NULL){out->segments->write(block, size);}
+	else{out->capture->write(block, size);}
+	out->pending = 0;
+}
+
+/* DRAIN function
+	Moves everything buffered in a session to its output files.
+*/
+void DRAIN (AcquisitionSession *session, output *out){
+	TRACE_SCOPE("drain");
+	RawSample batch[DRAIN_BATCH];
+	ResampledSample grid[DRAIN_BATCH];
+	char line[OUTPUT_LINE];
+	size_t n;
+	while ((n = session->pop(batch, DRAIN_BATCH)) > 0){
+		for (size_t i = 0; i < n && (out->block != NULL || out->store != NULL); i++){
+			codec_sample sample;
+			sample.time = batch[i].sampleTime;
+			sample.sequence = batch[i].sequence;
+			for (int a = 0; a < 3; a++){sample.axis[a] = (int16_t)(batch[i].data[2 * a] | batch[i].data[2 * a + 1] << 8);}
+			if (out->store != NULL){STORE_APPEND(out->store, &sample);}
+			if (out->block != NULL){
+				out->block[out->pending++] = sample;
+				if (out->pending == CODEC_BLOCK){ENCODE(out);}
+			}
+		}
+		for (size_t i = 0; i < n && out->pretty != NULL; i++){
+			int length = snprintf(line, sizeof(line), "%u\t0x%x 0x%x 0x%x 0x%x 0x%x 0x%x\n",	// Same layout as PDUMP
+				batch[i].sequence,
+				batch[i].data[0], batch[i].data[1],
+				batch[i].data[2], batch[i].data[3],
+				batch[i].data[4], batch[i].data[5]);
+			out->pretty->write(line, length);
+			length = snprintf(line, sizeof(line), "%u\t%lld\n", batch[i].sequence, batch[i].sampleTime);
+			out->times->write(line, length);
+		}
+		if (out->resampler != NULL){
+			out->resampler->push(batch, n);
+			size_t m;
+			while ((m = out->resampler->pull(grid, DRAIN_BATCH)) > 0){
+				for (size_t i = 0; i < m; i++){
+					int length = snprintf(line, sizeof(line), "%lld\t%.2f %.2f %.2f\n", grid[i].timestamp, grid[i].x, grid[i].y, grid[i].z);
+					out->grid->write(line, length);
+				}
+			}
+		}
+		long long now = latencyNow();
+		for (size_t i = 0; i < n; i++){pipelineLatency().record(LATENCY_WRITE, now - batch[i].timestamp);}
+	}
+}
+
+/* OPEN_OUTPUT function
+	Opens <prefix>-<bus>-<address>.<extension> for writing or exits.
+*/
+CaptureWriter *OPEN_OUTPUT (const char *prefix, int bus, int address, const char *extension = "txt"){
+	char filename[40];
+	snprintf(filename, sizeof(filename), "%s-%d-%#x.%s", prefix, bus, address, extension);
+	CaptureWriter *writer = new CaptureWriter();
+	if (writer->open(filename) != 0){
+		printf("Error: Trouble opening %s file.\n", filename);
+		exit(1);
+	}
+	return writer;
+}
+
+/* CLOSE_OUTPUT function
+	Closes a file opened by OPEN_OUTPUT and reports how it was written.
+*/
+void CLOSE_OUTPUT (CaptureWriter *writer, const char *name){
+	if (writer == NULL){return;}
+	if (writer->close() != 0){printf("Error: Trouble writing %s file.\n", name);}
+	printf("\t%s\t", name);
+	writer->report(stdout);
+	delete writer;
+}
+
+int main (int argc, char *argv[]){
+	bool simulated = false, traced = false, compressed = false;
+	double resample = 0, keep = 0, rollingMB = 0, rollingSeconds = 0;
+	while (argc > 1 && argv[1][0] == '-'){
+		if (strcmp(argv[1], "-sim") == 0){simulated = true;}
+		else if (strcmp(argv[1], "-trace") == 0){traced = true;}
+		else if (strcmp(argv[1], "-compress") == 0){compressed = true;}
+		else if (strcmp(argv[1], "-rolling") == 0 && argc > 2 && sscanf(argv[2], "%lf:%lf", &rollingMB, &rollingSeconds) >= 1 && rollingMB > 0){
+			compressed = true;
+			argc--; argv++;
+		}
+		else if (strcmp(argv[1], "-keep") == 0 && argc > 2 && (keep = atof(argv[2])) > 0){argc--; argv++;}
+		else if (strcmp(argv[1], "-resample") == 0 && argc > 2 && (resample = atof(argv[2])) > 0){argc--; argv++;}
+		else{
+			printf("Error: Unknown option %s.\n", argv[1]);
+			exit(1);
+		}
+		argc--; argv++;
+	}
+	if (argc < 3){
+		printf("Error: Expected seconds and at least one bus:address.\n");	// Inform the user of the error
+		exit(1);															// Exit with error
+	}
+	double seconds = atof(argv[1]);
+	
+	AcquisitionManager manager;
+	if (simulated){
+		manager.setTransportFactory([](int){
+			SimulatedLSM303 *device = new SimulatedLSM303();
+			device->setBusTiming(20000, 100000);				// Driver overhead, standard mode
+			device->setClockError(SIM_CLOCK_PPM);
+			device->writeRegister(CTRL_REG1_A, 0x97);			// 1344 Hz, all axes
+			return (I2CTransport *)device;
+		});
+	}
+	std::vector<output> outputs;
+	for (int i = 2; i < argc; i++){
+		int bus, address;
+		double rate = 100, odr = 0;
+		if (sscanf(argv[i], "%d:%i:%lf:%lf", &bus, &address, &rate, &odr) < 2){
+			printf("Error: \"%s\" is not bus:address[:rate[:odr]].\n", argv[i]);
+			exit(1);
+		}
+		if (odr == 0 && simulated){odr = 1344;}
+		AcquisitionSession *session = manager.addSession(bus, address, rate);
+		if (odr > 0){session->setSensorRate(odr);}
+		
+		output out = { NULL, NULL, NULL, NULL, NULL, 0, NULL, NULL, NULL };
+		if (rollingMB > 0){
+			char prefix[40];
+			snprintf(prefix, sizeof(prefix), "Capture-%d-%#x", bus, address);
+			out.segments = new RollingWriter();
+			if (out.segments->open(prefix, (size_t)(rollingMB * 1024 * 1024), rollingSeconds) != 0){
+				printf("Error: Trouble opening %s segments.\n", prefix);
+				exit(1);
+			}
+			if (out.segments->getRecovered() > 0){printf("%lu %s segments recovered\n", out.segments->getRecovered(), prefix);}
+			out.block = new codec_sample[CODEC_BLOCK];
+		}
+		else if (compressed){
+			out.capture = OPEN_OUTPUT("Capture", bus, address, "lsm");
+			out.block = new codec_sample[CODEC_BLOCK];
+		}
+		else{
+			out.pretty = OPEN_OUTPUT("PrettyData", bus, address);
+			out.times = OPEN_OUTPUT("Timestamps", bus, address);
+		}
+		if (keep > 0){
+			out.store = new sample_store;
+			STORE_INIT(out.store, (size_t)(keep * 1024 * 1024));
+		}
+		if (resample > 0){
+			out.grid = OPEN_OUTPUT("Resampled", bus, address);
+			out.resampler = new Resampler(resample, RESAMPLE_SINC);
+		}
+		outputs.push_back(out);
+	}
+	
+	pipelineLatency().watchSignal(SIGUSR1);
+	if (traced){
+		traceRecorder().setEnabled(true);
+		traceRecorder().nameThread("main");
+		traceRecorder().watchSignal(SIGUSR2);
+	}
+	manager.start();
+	long long lastCommit = SAMPLE_NOW();
+	for (double waited = 0; waited < seconds; waited += 0.1){	// Drain ten times a second
+		usleep(100000);
+		bool commit = rollingMB > 0 && SAMPLE_NOW() - lastCommit >= ROLLING_COMMIT * 1e9;
+		for (size_t i = 0; i < manager.getSessionCount(); i++){
+			DRAIN(manager.getSession(i), &outputs[i]);
+			if (commit){
+				ENCODE(&outputs[i]);						// Partial block, so the commit has every sample
+				outputs[i].segments->commit();				// On its thread
+			}
+		}
+		if (commit){lastCommit = SAMPLE_NOW();}
+		pipelineLatency().pollSignal(stderr);
+		traceRecorder().pollSignal(TRACE_FILE);
+	}
+	manager.stop();
+	
+	for (size_t i = 0; i < manager.getSessionCount(); i++){
+		AcquisitionSession *session = manager.getSession(i);
+		DRAIN(session, &outputs[i]);
+		if (outputs[i].block != NULL){ENCODE(&outputs[i]);}
+		printf("bus %d %#x\t%lu samples\t%lu dropped\t%lu duplicates\t%lu overruns\n", session->getBus(), session->getAddress(),
+			session->getProduced(), session->getDropped(), session->getDuplicates(), session->getOverruns());
+		sample_clock clock = session->getClock();
+		printf("\tclock\t");
+		CLOCK_PRINT(&clock, stdout);
+		CLOSE_OUTPUT(outputs[i].pretty, "pretty");
+		CLOSE_OUTPUT(outputs[i].times, "times");
+		CLOSE_OUTPUT(outputs[i].capture, "capture");
+		CLOSE_OUTPUT(outputs[i].grid, "resampled");
+		delete[] outputs[i].block;
+		delete outputs[i].resampler;
+		RollingWriter *segments = outputs[i].segments;
+		if (segments != NULL){
+			if (segments->close() != 0){printf("Error: Trouble writing segments.\n");}
+			printf("\tsegments\t");
+			segments->report(stdout);
+			delete segments;
+		}
+		sample_store *store = outputs[i].store;
+		if (store != NULL){
+			printf("\tstore\t%llu samples\t%llu dropped\t%zu bytes\t%.2f bytes/sample\n", store->samples, store->dropped,
+				STORE_BYTES(store), store->samples ? (double)STORE_BYTES(store) / store->samples : 0.0);
+			STORE_FREE(store);
+			delete store;
+		}
+	}
+	printf("aggregate\t%.1f samples/sec\n", manager.getThroughput());
+	pipelineLatency().report(stdout);
+	if (traced){printf("%d trace events in %s\n", traceRecorder().exportChrome(TRACE_FILE), TRACE_FILE);}
+	
+	return 0;	// TERMINATE MAIN PROGRAM
+}